@@ -2,5 +2,13 @@ C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\simple_shader.vert -o ..\shaders
 C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\simple_shader.frag -o ..\shaders\compiled_shaders\simple_shader.frag.spv
 C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\point_light.vert -o ..\shaders\compiled_shaders\point_light.vert.spv
 C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\point_light.frag -o ..\shaders\compiled_shaders\point_light.frag.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\point_light_bindless.vert -o ..\shaders\compiled_shaders\point_light_bindless.vert.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\cluster_lights.comp -o ..\shaders\compiled_shaders\cluster_lights.comp.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\gbuffer.frag -o ..\shaders\compiled_shaders\gbuffer.frag.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\fullscreen.vert -o ..\shaders\compiled_shaders\fullscreen.vert.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\deferred_ambient.frag -o ..\shaders\compiled_shaders\deferred_ambient.frag.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\light_volume.vert -o ..\shaders\compiled_shaders\light_volume.vert.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\light_volume.frag -o ..\shaders\compiled_shaders\light_volume.frag.spv
+C:\VulkanSDK\1.3.280.0\Bin\glslc.exe ..\shaders\deferred_composite.frag -o ..\shaders\compiled_shaders\deferred_composite.frag.spv
 mingw32-make buildwindows
 vulkan.exe
\ No newline at end of file
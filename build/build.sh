@@ -4,5 +4,13 @@
 /usr/bin/glslc ../shaders/simple_shader.frag -o ../shaders/compiled_shaders/simple_shader.frag.spv
 /usr/bin/glslc ../shaders/point_light.vert -o ../shaders/compiled_shaders/point_light.vert.spv
 /usr/bin/glslc ../shaders/point_light.frag -o ../shaders/compiled_shaders/point_light.frag.spv
+/usr/bin/glslc ../shaders/point_light_bindless.vert -o ../shaders/compiled_shaders/point_light_bindless.vert.spv
+/usr/bin/glslc ../shaders/cluster_lights.comp -o ../shaders/compiled_shaders/cluster_lights.comp.spv
+/usr/bin/glslc ../shaders/gbuffer.frag -o ../shaders/compiled_shaders/gbuffer.frag.spv
+/usr/bin/glslc ../shaders/fullscreen.vert -o ../shaders/compiled_shaders/fullscreen.vert.spv
+/usr/bin/glslc ../shaders/deferred_ambient.frag -o ../shaders/compiled_shaders/deferred_ambient.frag.spv
+/usr/bin/glslc ../shaders/light_volume.vert -o ../shaders/compiled_shaders/light_volume.vert.spv
+/usr/bin/glslc ../shaders/light_volume.frag -o ../shaders/compiled_shaders/light_volume.frag.spv
+/usr/bin/glslc ../shaders/deferred_composite.frag -o ../shaders/compiled_shaders/deferred_composite.frag.spv
 make buildlinux
 ./vulkan
\ No newline at end of file
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compares two benchmark reports written by --benchmark.
+
+    compare_benchmarks.py baseline.json candidate.json
+    compare_benchmarks.py --run ./old/vulkan ./new/vulkan --benchmark cubes --headless
+
+With --run both executables are run from their own directory with the remaining arguments,
+one after the other, before their reports are compared. Exits with 1 when a timing regressed
+by more than the threshold.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def run_benchmark(executable, args, output):
+    executable = os.path.abspath(executable)
+    # models and shaders are found relative to the working directory
+    subprocess.run([executable, *args, "--benchmark-output", output],
+                   cwd=os.path.dirname(executable), check=True)
+    with open(output) as report:
+        return json.load(report)
+
+
+def load(path):
+    with open(path) as report:
+        return json.load(report)
+
+
+def metrics(report):
+    rows = [("frame " + key, report["frameTimeMs"][key]) for key in ("mean", "p50", "p95", "p99")]
+    for phase, values in report["phasesMs"].items():
+        rows.append((phase + " mean", values["mean"]))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--run", action="store_true", help="treat the inputs as executables and run them")
+    parser.add_argument("--threshold", type=float, default=5.0, help="regression threshold in percent")
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parsed, extra = parser.parse_known_args()
+
+    if parsed.run:
+        with tempfile.TemporaryDirectory() as directory:
+            baseline = run_benchmark(parsed.baseline, extra, os.path.join(directory, "baseline.json"))
+            candidate = run_benchmark(parsed.candidate, extra, os.path.join(directory, "candidate.json"))
+    else:
+        baseline = load(parsed.baseline)
+        candidate = load(parsed.candidate)
+
+    for key in ("scene", "renderPath", "device", "width", "height", "objects", "lights"):
+        if baseline.get(key) != candidate.get(key):
+            print(f"warning: {key} differs, {baseline.get(key)} vs {candidate.get(key)}")
+
+    regressed = False
+    print(f"{'metric':<20}{'baseline ms':>14}{'candidate ms':>14}{'change':>10}")
+    for (name, before), (_, after) in zip(metrics(baseline), metrics(candidate)):
+        change = (after - before) / before * 100.0 if before > 0.0 else 0.0
+        # phases well under a millisecond are too noisy to judge by percentage alone
+        flag = change > parsed.threshold and after - before > 0.05
+        regressed |= flag and name.startswith("frame")
+        print(f"{name:<20}{before:>14.3f}{after:>14.3f}{change:>+9.1f}%{'  <-' if flag else ''}")
+
+    memory_before = baseline["memoryKb"]["peakResident"]
+    memory_after = candidate["memoryKb"]["peakResident"]
+    print(f"{'peak resident KiB':<20}{memory_before:>14}{memory_after:>14}")
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,25 @@
+#version 450
+
+layout (input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout (input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gDepth;
+
+layout (location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform globalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
+  int numLights;
+  int useSpec;
+  int clusterSlices;
+} ubo;
+
+void main() {
+    if (subpassLoad(gDepth).r >= 1.0) {
+        discard;
+    }
+    vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+    outColor = vec4(ambientLight * subpassLoad(gAlbedo).rgb, 1.0);
+}
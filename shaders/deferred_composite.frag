@@ -0,0 +1,14 @@
+#version 450
+
+layout (input_attachment_index = 0, set = 1, binding = 3) uniform subpassInput gLighting;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    vec4 lighting = subpassLoad(gLighting);
+    // background pixels were never lit, keep the swapchain clear color
+    if (lighting.a == 0.0) {
+        discard;
+    }
+    outColor = vec4(lighting.rgb, 1.0);
+}
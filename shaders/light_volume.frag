@@ -0,0 +1,72 @@
+#version 450
+
+layout (input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout (input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gNormal;
+layout (input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gDepth;
+
+layout (location = 0) flat in uint lightIndex;
+layout (location = 0) out vec4 outColor;
+
+struct PointLight {
+  vec4 position; // w is radius of influence
+  vec4 color; // w is intensity
+  vec4 billboard; // x is the radius of the drawn sprite
+};
+
+layout(set = 0, binding = 0) uniform globalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
+  int numLights;
+  int useSpec;
+  int clusterSlices;
+} ubo;
+
+layout(set = 0, binding = 1) readonly buffer LightBuffer {
+  PointLight pointLights[];
+} lightBuffer;
+
+vec3 worldPosition(float depth) {
+  vec2 ndc = gl_FragCoord.xy / ubo.clusterParams.zw * 2.0 - 1.0;
+  float viewZ = ubo.projection[3][2] / (depth - ubo.projection[2][2]);
+  vec3 viewPos = vec3(ndc.x * viewZ / ubo.projection[0][0], ndc.y * viewZ / ubo.projection[1][1], viewZ);
+  return (ubo.invView * vec4(viewPos, 1.0)).xyz;
+}
+
+// Same lighting model as simple_shader.frag, one light per invocation
+void main() {
+    float depth = subpassLoad(gDepth).r;
+    if (depth >= 1.0) {
+        discard;
+    }
+
+    vec3 fragPosWorld = worldPosition(depth);
+    PointLight light = lightBuffer.pointLights[lightIndex];
+    vec3 directionToLight = light.position.xyz - fragPosWorld;
+    float distanceSquared = dot(directionToLight, directionToLight);
+    if (distanceSquared > light.position.w * light.position.w) {
+        discard;
+    }
+
+    vec3 surfaceNormal = normalize(subpassLoad(gNormal).xyz);
+    vec3 viewDirection = normalize(ubo.invView[3].xyz - fragPosWorld);
+
+    float attenuation = 1.0 / distanceSquared;
+    directionToLight = normalize(directionToLight);
+
+    float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
+    vec3 intensity = light.color.xyz * light.color.w * attenuation;
+    vec3 lightColor = intensity * cosAngIncidence;
+
+    if (ubo.useSpec == 1) {
+        vec3 halfAngle = normalize(directionToLight + viewDirection);
+        float blinnTerm = dot(surfaceNormal, halfAngle);
+        blinnTerm = clamp(blinnTerm, 0, 1);
+        blinnTerm = pow(blinnTerm, 32.0);
+        lightColor += intensity * blinnTerm;
+    }
+
+    outColor = vec4(lightColor * subpassLoad(gAlbedo).rgb, 0.0);
+}
@@ -0,0 +1,61 @@
+#version 450
+
+const vec2 OFFSETS[6] = vec2[](
+  vec2(-1.0, -1.0),
+  vec2(-1.0, 1.0),
+  vec2(1.0, -1.0),
+  vec2(1.0, -1.0),
+  vec2(-1.0, 1.0),
+  vec2(1.0, 1.0)
+);
+
+layout (location = 0) flat out uint lightIndex;
+
+struct PointLight {
+  vec4 position; // w is radius of influence
+  vec4 color; // w is intensity
+  vec4 billboard; // x is the radius of the drawn sprite
+};
+
+layout(set = 0, binding = 0) uniform globalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
+  int numLights;
+  int useSpec;
+  int clusterSlices;
+} ubo;
+
+layout(set = 0, binding = 1) readonly buffer LightBuffer {
+  PointLight pointLights[];
+} lightBuffer;
+
+// Screen aligned quad in front of the light that covers its sphere of influence
+void main() {
+  lightIndex = gl_InstanceIndex;
+  PointLight light = lightBuffer.pointLights[gl_InstanceIndex];
+  vec2 offset = OFFSETS[gl_VertexIndex];
+
+  vec3 toCamera = ubo.invView[3].xyz - light.position.xyz;
+  float distance = length(toCamera);
+  float radius = light.position.w;
+
+  // camera is inside (or close to) the volume, cover the whole screen
+  if (distance < 2.0 * radius + ubo.clusterParams.x) {
+    gl_Position = vec4(offset, 0.0, 1.0);
+    return;
+  }
+
+  vec3 forward = toCamera / distance;
+  vec3 up = abs(forward.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, -1.0, 0.0);
+  vec3 right = normalize(cross(up, forward));
+  up = cross(forward, right);
+
+  vec3 positionWorld = light.position.xyz + forward * radius
+    + radius * offset.x * right
+    + radius * offset.y * up;
+
+  gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
+}
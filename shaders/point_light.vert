@@ -9,37 +9,45 @@ const vec2 OFFSETS[6] = vec2[](
   vec2(1.0, 1.0)
 );
 
-layout (location = 0) out vec2 fragOffset;
-
 struct PointLight {
-  vec4 position; // ignore w
+  vec4 position; // w is radius of influence
   vec4 color; // w is intensity
+  vec4 billboard; // x is the radius of the drawn sprite
 };
 
+layout (location = 0) out vec2 fragOffset;
+layout (location = 1) out vec3 fragColor;
+
 layout(set = 0, binding = 0) uniform globalUbo {
   mat4 projection;
   mat4 view;
   mat4 invView;
   vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
   int numLights;
   int useSpec;
+  int clusterSlices;
 } ubo;
 
-layout(push_constant) uniform Push {
-  vec4 position;
-  vec4 color;
-  float radius;
-} push;
+layout(set = 0, binding = 1) readonly buffer LightBuffer {
+  PointLight pointLights[];
+} lightBuffer;
+
+// draw order of the instances, back to front when sorting is enabled
+layout(set = 1, binding = 0) readonly buffer DrawOrder {
+  uint lightIndices[];
+} drawOrder;
 
 void main() {
+  PointLight light = lightBuffer.pointLights[drawOrder.lightIndices[gl_InstanceIndex]];
   fragOffset = OFFSETS[gl_VertexIndex];
+  fragColor = light.color.xyz;
   vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
   vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-  vec3 positionWorld = push.position.xyz
-    + push.radius * fragOffset.x * cameraRightWorld
-    + push.radius * fragOffset.y * cameraUpWorld;
+  vec3 positionWorld = light.position.xyz
+    + light.billboard.x * fragOffset.x * cameraRightWorld
+    + light.billboard.x * fragOffset.y * cameraUpWorld;
 
   gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
-}
\ No newline at end of file
+}
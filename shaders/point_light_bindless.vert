@@ -0,0 +1,63 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// point_light.vert with the light and draw order buffers read from the bindless table
+
+const vec2 OFFSETS[6] = vec2[](
+  vec2(-1.0, -1.0),
+  vec2(-1.0, 1.0),
+  vec2(1.0, -1.0),
+  vec2(1.0, -1.0),
+  vec2(-1.0, 1.0),
+  vec2(1.0, 1.0)
+);
+
+struct PointLight {
+  vec4 position; // w is radius of influence
+  vec4 color; // w is intensity
+  vec4 billboard; // x is the radius of the drawn sprite
+};
+
+layout (location = 0) out vec2 fragOffset;
+layout (location = 1) out vec3 fragColor;
+
+layout(set = 0, binding = 0) uniform globalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
+  int numLights;
+  int useSpec;
+  int clusterSlices;
+} ubo;
+
+// both alias the storage buffer array of the bindless set, see BindlessDescriptors.hpp
+layout(set = 1, binding = 1) readonly buffer LightBuffer {
+  PointLight pointLights[];
+} lightBuffers[];
+
+// draw order of the instances, back to front when sorting is enabled
+layout(set = 1, binding = 1) readonly buffer DrawOrder {
+  uint lightIndices[];
+} drawOrders[];
+
+layout(push_constant) uniform Push {
+  uint lightBuffer;
+  uint drawOrder;
+} push;
+
+void main() {
+  uint lightIndex = drawOrders[push.drawOrder].lightIndices[gl_InstanceIndex];
+  PointLight light = lightBuffers[push.lightBuffer].pointLights[lightIndex];
+  fragOffset = OFFSETS[gl_VertexIndex];
+  fragColor = light.color.xyz;
+  vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
+  vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
+
+  vec3 positionWorld = light.position.xyz
+    + light.billboard.x * fragOffset.x * cameraRightWorld
+    + light.billboard.x * fragOffset.y * cameraUpWorld;
+
+  gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
+}
@@ -1,5 +1,11 @@
 #version 450
 
+const uint CLUSTER_X = 16;
+const uint CLUSTER_Y = 9;
+const uint CLUSTER_Z = 24;
+const uint CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
 layout (location = 2) in vec3 fragNormalWorld;
@@ -7,8 +13,9 @@ layout (location = 2) in vec3 fragNormalWorld;
 layout (location = 0) out vec4 outColor;
 
 struct PointLight {
-  vec4 position; // ignore w
+  vec4 position; // w is radius of influence
   vec4 color; // w is intensity
+  vec4 billboard; // x is the radius of the drawn sprite
 };
 
 layout(set = 0, binding = 0) uniform globalUbo {
@@ -16,16 +23,42 @@ layout(set = 0, binding = 0) uniform globalUbo {
   mat4 view;
   mat4 invView;
   vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
+  vec4 clusterParams; // x: near, y: far, z: screen width, w: screen height
   int numLights;
   int useSpec;
+  int clusterSlices;
 } ubo;
 
+layout(set = 0, binding = 1) readonly buffer LightBuffer {
+  PointLight pointLights[];
+} lightBuffer;
+
+layout(set = 0, binding = 2) readonly buffer ClusterGrid {
+  uint lightCounts[CLUSTER_COUNT];
+  uint overflowCount;
+  uint lightIndices[];
+} clusters;
+
 layout(push_constant) uniform Push {
   mat4 modelMatrix;
   mat4 normalMatrix;
 } push;
 
+uint clusterIndex() {
+    float near = ubo.clusterParams.x;
+    float far = ubo.clusterParams.y;
+    float viewZ = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+
+    // exponential depth slices, see cluster_lights.comp
+    uint slice = uint(max(log(viewZ / near) / log(far / near) * float(CLUSTER_Z), 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / ubo.clusterParams.zw * vec2(CLUSTER_X, CLUSTER_Y));
+
+    tile = min(tile, uvec2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    // host binned tiles only fill one slice
+    slice = min(slice, uint(ubo.clusterSlices) - 1);
+    return tile.x + tile.y * CLUSTER_X + slice * CLUSTER_X * CLUSTER_Y;
+}
+
 void main() {
     vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
     vec3 specularLight = vec3(0.0);
@@ -34,10 +67,17 @@ void main() {
     vec3 cameraPosWorld = ubo.invView[3].xyz;
     vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-    for (int i = 0; i < ubo.numLights; i++) {
-        PointLight light = ubo.pointLights[i];
+    uint cluster = clusterIndex();
+    uint lightCount = clusters.lightCounts[cluster];
+
+    for (uint i = 0; i < lightCount; i++) {
+        PointLight light = lightBuffer.pointLights[clusters.lightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
         vec3 directionToLight = light.position.xyz - fragPosWorld;
-        float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
+        float distanceSquared = dot(directionToLight, directionToLight);
+        if (distanceSquared > light.position.w * light.position.w) {
+            continue;
+        }
+        float attenuation = 1.0 / distanceSquared;
         directionToLight = normalize(directionToLight);
 
         float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
@@ -58,4 +98,4 @@ void main() {
     } else {
         outColor = vec4(diffuseLight * fragColor, 1.0);
     }
-}
\ No newline at end of file
+}
@@ -3,13 +3,24 @@
 #include "KeyboardMoveController.hpp"
 #include "systems/RenderSystem.hpp"
 #include "systems/PointLightSystem.hpp"
+#include "systems/LightClusterSystem.hpp"
+#include "systems/DeferredLightingSystem.hpp"
 #include "Buffer.hpp"
+#include "UniformRing.hpp"
+#include "BindlessDescriptors.hpp"
+#include "Simulation.hpp"
+#include "RenderGraph.hpp"
+#include "SecondaryCommandBuffers.hpp"
+#include "Benchmark.hpp"
+#include "GpuProfiler.hpp"
+#include "CpuProfiler.hpp"
 
 
 #include <stdexcept>
 #include <cassert>
 #include <array>
 #include <chrono>
+#include <fstream>
 #include <iostream>
 
 #define GLM_FORCE_RADIANS
@@ -18,133 +29,496 @@
 #include <glm/gtc/constants.hpp>
 
 #define MAX_FRAME_TIME 16.f
+// frames left out of benchmark results while caches and driver state warm up
+#define BENCHMARK_WARMUP_FRAMES 60
+// seconds between keyframes when recording a camera path
+#define CAMERA_RECORD_INTERVAL 0.1f
+// uniform memory each frame can allocate from the ring
+#define UNIFORM_RING_FRAME_BYTES (64 * 1024)
 
-App::App() {
-    globalPool = DescriptorPool::Builder(device)
-        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
-        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+App::App(Settings settings) : settings{settings} {
+    if (!settings.cpuTracePath.empty()) {
+        CpuProfiler::setThreadName("main");
+        CpuProfiler::setEnabled(true);
+    }
+    globalAllocator = DescriptorAllocator::Builder(device)
+        .addPoolRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f)
+        .addPoolRatio(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f)
+        .addPoolRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f)
         .build();
-    loadObjects();
+    if (!settings.replayPath.empty()) {
+        replayCapture = std::make_unique<FrameCapture>(FrameCapture::load(settings.replayPath));
+        if (replayCapture->renderPath != settings.renderPath) {
+            throw std::runtime_error(settings.replayPath + " was captured on another render path, pass --deferred or --forward to match");
+        }
+        for (auto& builder : replayCapture->models) {
+            models.push_back(std::make_unique<Model>(device, builder));
+        }
+    } else if (settings.benchmark) {
+        cameraPath = createBenchmarkScene(settings.benchmarkScene, settings.benchmarkCount, device, registry, sceneGraph, models);
+    } else {
+        loadObjects();
+    }
+    if (!settings.cameraPath.empty()) {
+        cameraPath = CameraPath::load(settings.cameraPath);
+    }
+
+    if (settings.quaternionTransforms) {
+        registry.view<TransformComponent>().each([](Entity, TransformComponent& transform) {
+            transform.convertToOrientation();
+        });
+    }
 }
 
 App::~App() {}
 
 void App::run() {
-    std::vector<std::unique_ptr<Buffer>> uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
-    for (int i = 0; i < uboBuffers.size(); i++) {
-        uboBuffers[i] = std::make_unique<Buffer>(
-            device,
-            sizeof(globalUbo),
-            1,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-        );
-        uboBuffers[i]->map();
-    }
+    UniformRing uniformRing{device, UNIFORM_RING_FRAME_BYTES};
 
     auto globalSetLayout = DescriptorSetLayout::Builder(device)
-        .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT)
         .build();
-    
+
+    RenderSystem renderSystem{device, renderer.getSwapChainRenderTarget(), globalSetLayout->getDescriptorSetLayout(), settings.renderPath};
+    std::unique_ptr<BindlessDescriptors> bindless;
+    if (settings.bindless) {
+        if (device.supportsDescriptorIndexing()) {
+            bindless = std::make_unique<BindlessDescriptors>(device);
+        } else {
+            std::cout << "Device does not support descriptor indexing, keeping per system descriptor sets" << std::endl;
+        }
+    }
+
+    PointLightSystem pointLightSystem{device, renderer.getSwapChainRenderTarget(), globalSetLayout->getDescriptorSetLayout(), settings.renderPath, settings.sortLightBillboards, bindless.get()};
+    LightClusterSystem lightClusterSystem{device, globalSetLayout->getDescriptorSetLayout(), settings.cpuLightCulling};
+    std::unique_ptr<DeferredLightingSystem> deferredLightingSystem;
+    if (settings.renderPath == RenderPath::Deferred) {
+        deferredLightingSystem = std::make_unique<DeferredLightingSystem>(device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+    }
+
+    // scene draws are split across jobs, each recording its own secondary command buffers
+    std::unique_ptr<SecondaryCommandBuffers> secondaries;
+    if (settings.parallelRecording) {
+        secondaries = std::make_unique<SecondaryCommandBuffers>(device);
+    }
+
     std::vector<VkDescriptorSet> globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    std::vector<VkBuffer> writtenLightBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
     for(int i = 0; i < globalDescriptorSets.size(); i++) {
-       auto bufferInfo = uboBuffers[i]->descriptorInfo();
-       DescriptorWriter(*globalSetLayout, *globalPool)
+       auto bufferInfo = uniformRing.descriptorInfo(sizeof(globalUbo));
+       auto lightInfo = pointLightSystem.lightBufferInfo(i);
+       auto clusterInfo = lightClusterSystem.clusterBufferInfo(i);
+       writtenLightBuffers[i] = lightInfo.buffer;
+       DescriptorWriter(*globalSetLayout, *globalAllocator)
         .writeBuffer(0, &bufferInfo)
+        .writeBuffer(1, &lightInfo)
+        .writeBuffer(2, &clusterInfo)
         .build(globalDescriptorSets[i]);
     }
-
-    RenderSystem renderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
-    PointLightSystem pointLightSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
     Camera camera{};
     // camera.setViewDirection(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 1.f));
     camera.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
 
-    auto viewerObject = Object::createObject();
+    // the camera follows input every frame, so it stays on the render thread outside the registry
+    TransformComponent viewerTransform{};
+    int useSpec = 1;
     KeyboardMoveController cameraController{};
     KeyboardMoveController settingsController{};
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
+    // filled every frame before the graph runs, deferred lighting reads the light count from it
+    globalUbo ubo{};
+
+    if (settings.checkAliasing) {
+        // the frame below has no transients yet, so the aliasing path is checked on its own
+        RenderGraph::checkAliasing(device);
+    }
+    // a draw stream logs commands in the order they are issued, so those frames record inline
+    auto recordInJobs = [&](const FrameInfo& frameInfo) { return secondaries && !frameInfo.drawStream; };
+
+    RenderGraph renderGraph{device};
+    RenderResource swapChainImage = renderGraph.importImage("swapchain");
+    RenderResource clusterGrid = renderGraph.importBuffer("cluster grid");
+    if (settings.renderPath == RenderPath::Deferred) {
+        renderGraph.addPass("deferred", [&](FrameInfo& frameInfo) {
+            if (recordInJobs(frameInfo)) {
+                renderer.beginSwapChainRenderPass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                std::vector<VkCommandBuffer> commandBuffers;
+                renderSystem.recordObjects(frameInfo, *secondaries, renderer.getSecondaryTarget(0), commandBuffers);
+                if (!commandBuffers.empty()) {
+                    vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+                }
+            } else {
+                renderer.beginSwapChainRenderPass(frameInfo.commandBuffer);
+                renderSystem.renderObjects(frameInfo);
+            }
+            renderer.nextSubpass(frameInfo.commandBuffer);
+            deferredLightingSystem->renderLighting(frameInfo, renderer.getCurrentGBufferViews(), ubo.numLights);
+            renderer.nextSubpass(frameInfo.commandBuffer);
+            deferredLightingSystem->renderComposite(frameInfo);
+            pointLightSystem.render(frameInfo);
+            renderer.endSwapChainRenderPass(frameInfo.commandBuffer);
+        }).write(swapChainImage, ResourceUsage::ColorAttachment, renderer.getSwapChainFinalLayout());
+    } else {
+        if (!settings.cpuLightCulling) {
+            //bin lights into clusters
+            renderGraph.addPass("light culling", [&](FrameInfo& frameInfo) {
+                lightClusterSystem.compute(frameInfo, pointLightSystem.getLights());
+            }).write(clusterGrid, ResourceUsage::StorageWriteCompute);
+        }
+        renderGraph.addPass("forward", [&](FrameInfo& frameInfo) {
+            if (recordInJobs(frameInfo)) {
+                renderer.beginSwapChainRenderPass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                SecondaryTarget target = renderer.getSecondaryTarget(0);
+                std::vector<VkCommandBuffer> commandBuffers;
+                renderSystem.recordObjects(frameInfo, *secondaries, target, commandBuffers);
+                // the subpass only takes secondaries now, and the billboards blend over the objects
+                commandBuffers.push_back(secondaries->record(target, [&](VkCommandBuffer commandBuffer) {
+                    FrameInfo lightInfo = frameInfo;
+                    lightInfo.commandBuffer = commandBuffer;
+                    lightInfo.profiler = nullptr;
+                    pointLightSystem.render(lightInfo);
+                }));
+                vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+                renderer.endSwapChainRenderPass(frameInfo.commandBuffer);
+                return;
+            }
+            renderer.beginSwapChainRenderPass(frameInfo.commandBuffer);
+            renderSystem.renderObjects(frameInfo);
+            pointLightSystem.render(frameInfo);
+            renderer.endSwapChainRenderPass(frameInfo.commandBuffer);
+        })
+            .read(clusterGrid, ResourceUsage::StorageReadFragment)
+            .write(swapChainImage, ResourceUsage::ColorAttachment, renderer.getSwapChainFinalLayout());
+    }
+    // headless images are copied out instead of presented
+    renderGraph.setFinalUsage(swapChainImage, settings.headless ? ResourceUsage::TransferSrc : ResourceUsage::Present);
+    renderGraph.compile();
+
+    std::unique_ptr<GpuProfiler> profiler;
+    if (settings.passTimings) {
+        profiler = std::make_unique<GpuProfiler>(device, settings.pipelineStatistics);
+        if (settings.pipelineStatistics && !profiler->hasPipelineStatistics()) {
+            std::cout << "pipeline statistics queries are not supported, timing passes only\n";
+        }
+    }
+
+    Simulation simulation{registry, sceneGraph, settings.simulationTickRate};
+    simulation.start(!settings.fixedTimestep);
+    SceneState scene{};
+
+    BenchmarkRecorder benchmark{settings.benchmark, BENCHMARK_WARMUP_FRAMES};
+    CameraPath recordedPath{};
+    float pathTime = 0.f;
+    float recordTimer = 0.f;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    auto currentTime = startTime;
+    float statsTimer = 0.f;
+    uint32_t framesRendered = 0;
+
+    // nothing in the scene can be evicted yet, so a heap nearing its budget is only reported
+    uint32_t evictionCallback = device.memoryTracker().addEvictionCallback([](uint32_t heapIndex, const HeapBudget& heap) {
+        std::cout << "memory heap " << heapIndex << " is at " << heap.usage * 100 / heap.budget << "% of its budget\n";
+    });
+
+    FrameCapture frameCapture{};
+    bool frameCaptured = false;
+    DrawStream replayStream{};
+    if (replayCapture) {
+        // nothing moves during a replay, the captured scene and viewer are drawn every frame
+        scene = replayCapture->scene(models);
+        viewerTransform.translation = replayCapture->viewerTranslation;
+        viewerTransform.rotation = replayCapture->viewerRotation;
+        useSpec = replayCapture->useSpec;
+        VkExtent2D extent = renderer.getSwapChainExtent();
+        if (extent.width != replayCapture->extent.width || extent.height != replayCapture->extent.height) {
+            std::cout << "replaying a " << replayCapture->extent.width << "x" << replayCapture->extent.height
+                << " capture at " << extent.width << "x" << extent.height << ", the global ubo will differ\n";
+        }
+    }
 
-    while(!window.shouldClose()) {
-        glfwPollEvents();
+    while(!window.shouldClose() && (settings.frameCount == 0 || framesRendered < settings.frameCount)) {
+        PROFILE_SCOPE("frame");
+        benchmark.beginFrame();
+        if (!window.isHeadless()) {
+            PROFILE_SCOPE("poll events");
+            glfwPollEvents();
+        }
 
         auto newTime = std::chrono::high_resolution_clock::now();
         float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
         currentTime = newTime;
 
         frameTime = glm::min(frameTime, MAX_FRAME_TIME);
+        if (settings.fixedTimestep) {
+            frameTime = 1.f / simulation.getTickRate();
+        }
+        if (replayCapture) {
+            frameTime = replayCapture->frameTime;
+        }
 
-        cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewerObject);
-        camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+        device.pollMemoryBudget();
 
-        settingsController.settings(window.getGLFWwindow(), frameTime, viewerObject);
+        statsTimer += frameTime;
+        if (statsTimer >= 1.f) {
+            if (settings.memoryReport) {
+                device.memoryTracker().printReport(std::cout);
+            }
+            if (settings.transformStats) {
+                std::cout << "transforms: " << TransformComponent::stats.recomputed.exchange(0) << " recomputed, "
+                    << TransformComponent::stats.reused.exchange(0) << " reused\n";
+            }
+            if (profiler) {
+                profiler->print(std::cout);
+            }
+            if (uint32_t dropped = lightClusterSystem.overflowCount()) {
+                std::cout << "light clusters full: " << dropped
+                    << " light references dropped, raise MAX_LIGHTS_PER_CLUSTER\n";
+            }
+            statsTimer = 0.f;
+        }
+
+        {
+            PROFILE_SCOPE("camera");
+            pathTime += frameTime;
+            if (replayCapture) {
+                // placed from the capture before the loop
+            } else if (!cameraPath.empty()) {
+                cameraPath.sample(pathTime, viewerTransform);
+            } else if (!window.isHeadless()) {
+                cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewerTransform);
+            }
+            if (!window.isHeadless()) {
+                settingsController.settings(window.getGLFWwindow(), frameTime, useSpec);
+            }
+            camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
+
+            if (!settings.recordCameraPath.empty()) {
+                recordTimer -= frameTime;
+                if (recordTimer <= 0.f) {
+                    recordedPath.addKeyframe(pathTime, viewerTransform.translation, viewerTransform.rotation);
+                    recordTimer = CAMERA_RECORD_INTERVAL;
+                }
+            }
+        }
+        benchmark.lap(BenchmarkPhase::Input);
+
+        {
+            PROFILE_SCOPE("simulation");
+            if (!replayCapture) {
+                if (settings.fixedTimestep) {
+                    simulation.step();
+                }
+                simulation.sample(scene);
+            }
+        }
+        benchmark.lap(BenchmarkPhase::Simulation);
 
         float aspect = renderer.getAspectRatio();
         // camera.setOrthographicProjection(-aspect,aspect,-1,1,-1,1);
         camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 30.f);
 
         if(auto commandBuffer = renderer.beginFrame()) {
+            benchmark.lap(BenchmarkPhase::Acquire);
             int frameIndex = renderer.getFrameIndex();
+            uniformRing.beginFrame(frameIndex);
+            if (secondaries) {
+                secondaries->beginFrame(frameIndex);
+            }
+            if (bindless) {
+                bindless->beginFrame();
+            }
+            // the capture frame logs its stream to save it, the first replayed frame to check it
+            bool capturingFrame = !settings.streamCapturePath.empty() && framesRendered == settings.streamCaptureFrame;
+            bool checkingReplay = replayCapture && framesRendered == 0;
+            //this frame index's fence has signaled, so its previous timestamps are available
+            if (profiler) {
+                profiler->beginFrame(commandBuffer, frameIndex);
+            }
             FrameInfo frameInfo {
                 frameIndex,
                 frameTime,
                 commandBuffer,
                 camera,
                 globalDescriptorSets[frameIndex],
-                objects
+                0,
+                scene,
+                profiler.get(),
+                capturingFrame ? &frameCapture.stream : checkingReplay ? &replayStream : nullptr
             };
 
             //update
-            globalUbo ubo{};
-            ubo.useSpec = viewerObject.useSpec;
-            ubo.projection = camera.getProjection();
-            ubo.view = camera.getView();
-            ubo.inverseView = camera.getInverseView();
-            pointLightSystem.update(frameInfo, ubo);
-            uboBuffers[frameIndex]->writeToBuffer(&ubo);
-            uboBuffers[frameIndex]->flush();
-
-            //render
-            renderer.beginSwapChainRenderPass(commandBuffer);
-            renderSystem.renderObjects(frameInfo);
-            pointLightSystem.render(frameInfo);
-            renderer.endSwapChainRenderPass(commandBuffer);
+            {
+                PROFILE_SCOPE("update");
+                ubo = globalUbo{};
+                ubo.useSpec = useSpec;
+                ubo.projection = camera.getProjection();
+                ubo.view = camera.getView();
+                ubo.inverseView = camera.getInverseView();
+                auto extent = renderer.getSwapChainExtent();
+                ubo.clusterParams = glm::vec4(camera.getNear(), camera.getFar(), extent.width, extent.height);
+                ubo.clusterSlices = lightClusterSystem.sliceCount();
+                pointLightSystem.update(frameInfo, ubo);
+                if (frameInfo.drawStream) {
+                    auto& lights = pointLightSystem.getLights();
+                    frameInfo.drawStream->bufferContents("global ubo", &ubo, sizeof(ubo));
+                    frameInfo.drawStream->bufferContents("point lights", lights.data(), lights.size() * sizeof(PointLight));
+                }
+                //the light buffer may have grown, this frame's set is no longer in use so it can be rewritten
+                auto lightInfo = pointLightSystem.lightBufferInfo(frameIndex);
+                if (lightInfo.buffer != writtenLightBuffers[frameIndex]) {
+                    DescriptorWriter(*globalSetLayout, *globalAllocator)
+                        .writeBuffer(1, &lightInfo)
+                        .overwrite(globalDescriptorSets[frameIndex]);
+                    writtenLightBuffers[frameIndex] = lightInfo.buffer;
+                }
+                frameInfo.globalUboOffset = uniformRing.push(ubo);
+
+                //host binning has no gpu work, so it runs before the graph rather than as a pass
+                if (settings.renderPath == RenderPath::Forward && settings.cpuLightCulling) {
+                    lightClusterSystem.compute(frameInfo, pointLightSystem.getLights());
+                }
+            }
+
+            benchmark.lap(BenchmarkPhase::Update);
+
+            {
+                PROFILE_SCOPE("record");
+                renderGraph.setImage(swapChainImage, renderer.getCurrentSwapChainImage());
+                renderGraph.setBuffer(clusterGrid, lightClusterSystem.clusterBufferInfo(frameIndex).buffer);
+                renderGraph.execute(frameInfo);
+                if (profiler) {
+                    profiler->endFrame(commandBuffer);
+                }
+            }
+            benchmark.lap(BenchmarkPhase::Record);
+
+            if (capturingFrame) {
+                frameCapture.renderPath = settings.renderPath;
+                frameCapture.extent = renderer.getSwapChainExtent();
+                frameCapture.frameTime = frameTime;
+                frameCapture.useSpec = useSpec;
+                frameCapture.viewerTranslation = viewerTransform.translation;
+                frameCapture.viewerRotation = viewerTransform.rotation;
+                for (auto& object : scene.objects) {
+                    uint32_t model = frameCapture.stream.modelIndex(object.model);
+                    assert(model != UINT32_MAX && "Every scene object is drawn, so its model is in the stream");
+                    frameCapture.objects.push_back({model, object.modelMatrix, object.normalMatrix});
+                }
+                frameCapture.lights = scene.lights;
+                frameCaptured = true;
+            }
+            if (checkingReplay) {
+                const DrawStream& expected = replayCapture->stream;
+                size_t difference = expected.firstDifference(replayStream);
+                if (difference == SIZE_MAX) {
+                    std::cout << "draw stream matches the capture, " << replayStream.size() << " commands, hash "
+                        << std::hex << replayStream.hash() << std::dec << "\n";
+                } else {
+                    replayMismatch = true;
+                    std::cout << "draw stream differs from the capture at command " << difference
+                        << ": captured " << expected.describe(difference)
+                        << ", replayed " << replayStream.describe(difference) << "\n";
+                }
+            }
             renderer.endFrame();
+            benchmark.lap(BenchmarkPhase::Submit);
+            benchmark.endFrame();
+            framesRendered++;
         }
     }
+    simulation.stop();
     vkDeviceWaitIdle(device.device());
+    device.memoryTracker().removeEvictionCallback(evictionCallback);
+
+    if (settings.frameCount != 0) {
+        float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "rendered " << framesRendered << " frames in " << seconds << " s, "
+            << seconds * 1000.f / framesRendered << " ms per frame\n";
+    }
+    if (settings.benchmark) {
+        BenchmarkInfo info{
+            benchmarkSceneName(settings.benchmarkScene),
+            settings.renderPath == RenderPath::Deferred ? "deferred" : "forward",
+            device.properties.deviceName,
+            renderer.getSwapChainExtent(),
+            scene.objects.size(),
+            scene.lights.size()};
+        std::ofstream out{settings.benchmarkOutput};
+        if (!out) {
+            throw std::runtime_error("Failed to open " + settings.benchmarkOutput + " for writing");
+        }
+        benchmark.writeJson(out, info);
+        benchmark.printSummary(std::cout);
+        std::cout << "benchmark results written to " << settings.benchmarkOutput << "\n";
+    }
+    if (!settings.recordCameraPath.empty()) {
+        recordedPath.save(settings.recordCameraPath);
+        std::cout << "camera path written to " << settings.recordCameraPath << "\n";
+    }
+    if (!settings.capturePath.empty()) {
+        renderer.captureLastFrame(settings.capturePath);
+        std::cout << "captured last frame to " << settings.capturePath << "\n";
+    }
+    if (frameCaptured) {
+        // the meshes are read back only now, the copies wait on the queue
+        for (const Model* model : frameCapture.stream.getModels()) {
+            frameCapture.models.push_back(model->readBack());
+        }
+        frameCapture.save(settings.streamCapturePath);
+        std::cout << "frame " << settings.streamCaptureFrame << " captured to " << settings.streamCapturePath
+            << ", " << frameCapture.stream.size() << " commands\n";
+    } else if (!settings.streamCapturePath.empty()) {
+        std::cout << "the run ended before frame " << settings.streamCaptureFrame << ", nothing was captured\n";
+    }
+    if (!settings.cpuTracePath.empty()) {
+        std::ofstream out{settings.cpuTracePath};
+        if (!out) {
+            throw std::runtime_error("Failed to open " + settings.cpuTracePath + " for writing");
+        }
+        CpuProfiler::writeChromeTrace(out);
+        std::cout << "cpu trace written to " << settings.cpuTracePath << "\n";
+    }
 }
 
 void App::loadObjects() {
-    std::shared_ptr<Model> floor = Model::createModelFromFile(device, "../models/quad.obj");
-    auto floor_obj = Object::createObject();
-    floor_obj.model = floor;
-    floor_obj.transform.translation = {0.f, 0.5f, 0.f};
-    floor_obj.transform.scale = glm::vec3(3.f, 1.f, 3.f);
-    objects.emplace(floor_obj.getId(), std::move(floor_obj));
-
-    std::shared_ptr<Model> stormtrooper = Model::createModelFromFile(device, "../models/stormtrooper.obj");
-    auto stormtrooper_obj = Object::createObject();
-    stormtrooper_obj.model = stormtrooper;
-    stormtrooper_obj.transform.translation = {.0f, .5f, 0.f};
-    stormtrooper_obj.transform.scale = glm::vec3(1.0f);
-    stormtrooper_obj.shouldRotateY = true;
-    objects.emplace(stormtrooper_obj.getId(), std::move(stormtrooper_obj));
-
-    std::shared_ptr<Model> vase = Model::createModelFromFile(device, "../models/smooth_vase.obj");
-    auto vase_obj = Object::createObject();
-    vase_obj.model = vase;
-    vase_obj.transform.translation = {-2.0f, .5f, 0.f};
-    vase_obj.transform.scale = glm::vec3(4.0f);
-    objects.emplace(vase_obj.getId(), std::move(vase_obj));
-
-    std::shared_ptr<Model> colored_cube = Model::createModelFromFile(device, "../models/colored_cube.obj");
-    auto colored_cube_obj = Object::createObject();
-    colored_cube_obj.model = colored_cube;
-    colored_cube_obj.transform.translation = {2.2f, 0.0f, 0.f};
-    colored_cube_obj.transform.scale = glm::vec3(0.5f);
-    objects.emplace(colored_cube_obj.getId(), std::move(colored_cube_obj));
+    models = Model::createModelsFromFiles(device, {
+        "../models/quad.obj",
+        "../models/stormtrooper.obj",
+        "../models/smooth_vase.obj",
+        "../models/colored_cube.obj"
+    });
+
+    Entity floor = registry.create();
+    registry.add<ModelComponent>(floor, {models[0].get()});
+    auto& floorTransform = registry.add<TransformComponent>(floor);
+    floorTransform.translation = {0.f, 0.5f, 0.f};
+    floorTransform.scale = glm::vec3(3.f, 1.f, 3.f);
+    sceneGraph.setParent(floor);
+
+    Entity stormtrooper = registry.create();
+    registry.add<ModelComponent>(stormtrooper, {models[1].get()});
+    auto& stormtrooperTransform = registry.add<TransformComponent>(stormtrooper);
+    stormtrooperTransform.translation = {.0f, .5f, 0.f};
+    stormtrooperTransform.scale = glm::vec3(1.0f);
+    registry.add<SpinComponent>(stormtrooper);
+    sceneGraph.setParent(stormtrooper);
+
+    Entity vase = registry.create();
+    registry.add<ModelComponent>(vase, {models[2].get()});
+    auto& vaseTransform = registry.add<TransformComponent>(vase);
+    vaseTransform.translation = {-2.0f, .5f, 0.f};
+    vaseTransform.scale = glm::vec3(4.0f);
+    sceneGraph.setParent(vase);
+
+    Entity coloredCube = registry.create();
+    registry.add<ModelComponent>(coloredCube, {models[3].get()});
+    auto& coloredCubeTransform = registry.add<TransformComponent>(coloredCube);
+    coloredCubeTransform.translation = {2.2f, 0.0f, 0.f};
+    coloredCubeTransform.scale = glm::vec3(0.5f);
+    sceneGraph.setParent(coloredCube);
 
     std::vector<glm::vec3> lightColors{
         {1.f, .1f, .1f},
@@ -155,11 +529,18 @@ void App::loadObjects() {
         {1.f, 1.f, 1.f} 
     };
 
+    // the lights orbit with this pivot instead of being moved one by one
+    Entity lightPivot = registry.create();
+    registry.add<TransformComponent>(lightPivot);
+    registry.add<SpinComponent>(lightPivot, {-1.f});
+    sceneGraph.setParent(lightPivot);
+
     for(int i = 0; i < lightColors.size(); i++) {
-        auto pLight = Object::makePointLight(0.7f);
-        pLight.color = lightColors[i];
+        Entity light = registry.create();
+        registry.add<PointLightComponent>(light).lightIntensity = 0.7f;
+        registry.add<ColorComponent>(light, {lightColors[i]});
         auto rotateLight = glm::rotate(glm::mat4(1.f), (i * glm::two_pi<float>()) / lightColors.size(), {0.f, -1.f, 0.f});
-        pLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
-        objects.emplace(pLight.getId(), std::move(pLight));
+        registry.add<TransformComponent>(light).translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
+        sceneGraph.setParent(light, lightPivot);
     }
-}
\ No newline at end of file
+}
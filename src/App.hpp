@@ -1,10 +1,15 @@
 #pragma once
 
 #include "Window.hpp"
-#include "Object.hpp"
+#include "Registry.hpp"
+#include "SceneGraph.hpp"
+#include "Model.hpp"
 #include "Device.hpp"
 #include "Renderer.hpp"
 #include "Descriptors.hpp"
+#include "Settings.hpp"
+#include "CameraPath.hpp"
+#include "FrameCapture.hpp"
 #include <memory>
 #include <vector>
 
@@ -13,21 +18,32 @@ class App{
         static constexpr int WIDTH = 1600;
         static constexpr int HEIGHT = 1200;
 
-        App();
+        App(Settings settings = Settings{});
         ~App();
 
         App(const App&) = delete;
         App& operator=(const App &) = delete;
 
         void run();
+        // true once a --replay frame drew a different stream than the capture
+        bool replayMismatched() const { return replayMismatch; }
 
     private:
         void loadObjects();
 
-        Window window{WIDTH, HEIGHT, "VULKAN_3D_RENDERER"};
+        Settings settings;
+        Window window{WIDTH, HEIGHT, "VULKAN_3D_RENDERER", settings.headless};
         Device device{window};
-        Renderer renderer{window, device};
-
-        std::unique_ptr<DescriptorPool> globalPool{};
-        Object::Map objects;
+        Renderer renderer{window, device, settings.renderPath, settings.dynamicRendering};
+
+        // sets that live as long as the app, grows as materials and objects add their own
+        std::unique_ptr<DescriptorAllocator> globalAllocator{};
+        Registry registry;
+        SceneGraph sceneGraph;
+        std::vector<std::unique_ptr<Model>> models;
+        // drives the camera when not empty, from a benchmark scene or --camera-path
+        CameraPath cameraPath;
+        // the frame drawn over and over instead of the scene, from --replay
+        std::unique_ptr<FrameCapture> replayCapture;
+        bool replayMismatch{false};
 };
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "Benchmark.hpp"
+#include "Components.hpp"
+#include "JobSystem.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#define DEFAULT_CUBE_COUNT 10000
+#define DEFAULT_LIGHT_COUNT 1024
+#define DEFAULT_MESH_COUNT 8
+
+#define CUBE_SPACING 0.25f
+#define SPHERE_RINGS 256
+#define SPHERE_SEGMENTS 512
+// seconds per camera orbit, long enough that a default run sees most of the scene
+#define BENCHMARK_ORBIT_SECONDS 20.f
+// fixed so every run and build places the same lights
+#define BENCHMARK_SEED 1234
+
+namespace {
+    const char* phaseName(size_t phase) {
+        static const char* names[] = {"input", "simulation", "acquire", "update", "record", "submit"};
+        return names[phase];
+    }
+
+    // nearest rank on an already sorted sample
+    float percentile(const std::vector<float>& sorted, float p) {
+        if (sorted.empty()) return 0.f;
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.f * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    float mean(const std::vector<float>& values) {
+        if (values.empty()) return 0.f;
+        double sum = 0.0;
+        for (float value : values) sum += value;
+        return static_cast<float>(sum / values.size());
+    }
+
+    // resident and peak resident set of the process in KiB, zero where /proc is unavailable
+    void processMemory(uint64_t& residentKb, uint64_t& peakKb) {
+        residentKb = peakKb = 0;
+        std::ifstream status{"/proc/self/status"};
+        std::string line;
+        while (std::getline(status, line)) {
+            std::istringstream fields{line};
+            std::string key;
+            fields >> key;
+            if (key == "VmRSS:") fields >> residentKb;
+            if (key == "VmHWM:") fields >> peakKb;
+        }
+    }
+
+    std::string jsonString(const std::string& value) {
+        std::string escaped = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+
+    Entity addObject(Registry& registry, SceneGraph& sceneGraph, Model* model, const glm::vec3& translation, float scale) {
+        Entity entity = registry.create();
+        registry.add<ModelComponent>(entity, {model});
+        auto& transform = registry.add<TransformComponent>(entity);
+        transform.translation = translation;
+        transform.scale = glm::vec3(scale);
+        sceneGraph.setParent(entity);
+        return entity;
+    }
+
+    void addLight(Registry& registry, SceneGraph& sceneGraph, Entity pivot, const glm::vec3& translation, const glm::vec3& color, float intensity) {
+        Entity light = registry.create();
+        registry.add<PointLightComponent>(light).lightIntensity = intensity;
+        registry.add<ColorComponent>(light, {color});
+        registry.add<TransformComponent>(light).translation = translation;
+        sceneGraph.setParent(light, pivot);
+    }
+
+    Entity addLightPivot(Registry& registry, SceneGraph& sceneGraph, float speed) {
+        Entity pivot = registry.create();
+        registry.add<TransformComponent>(pivot);
+        registry.add<SpinComponent>(pivot, {speed});
+        sceneGraph.setParent(pivot);
+        return pivot;
+    }
+
+    // a few white lights circling above the scene so the geometry scenes are lit
+    void addRingLights(Registry& registry, SceneGraph& sceneGraph, float radius, float height, int count) {
+        Entity pivot = addLightPivot(registry, sceneGraph, -0.5f);
+        for (int i = 0; i < count; i++) {
+            float angle = i * glm::two_pi<float>() / count;
+            addLight(registry, sceneGraph, pivot, {std::sin(angle) * radius, -height, std::cos(angle) * radius}, glm::vec3{1.f}, 1.f);
+        }
+    }
+
+    Model::Builder createSphere(uint32_t rings, uint32_t segments, const glm::vec3& color) {
+        Model::Builder builder{};
+        builder.vertices.reserve((rings + 1) * (segments + 1));
+        for (uint32_t ring = 0; ring <= rings; ring++) {
+            float theta = glm::pi<float>() * ring / rings;
+            for (uint32_t segment = 0; segment <= segments; segment++) {
+                float phi = glm::two_pi<float>() * segment / segments;
+                Model::Vertex vertex{};
+                vertex.normal = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                vertex.position = vertex.normal;
+                vertex.color = color;
+                vertex.uv = {static_cast<float>(segment) / segments, static_cast<float>(ring) / rings};
+                builder.vertices.push_back(vertex);
+            }
+        }
+        builder.indices.reserve(rings * segments * 6);
+        for (uint32_t ring = 0; ring < rings; ring++) {
+            for (uint32_t segment = 0; segment < segments; segment++) {
+                uint32_t current = ring * (segments + 1) + segment;
+                uint32_t below = current + segments + 1;
+                builder.indices.insert(builder.indices.end(), {current, below, current + 1, current + 1, below, below + 1});
+            }
+        }
+        return builder;
+    }
+
+    CameraPath createCubes(uint32_t count, Device& device, Registry& registry, SceneGraph& sceneGraph, std::vector<std::unique_ptr<Model>>& models) {
+        models.push_back(Model::createModelFromFile(device, "../models/colored_cube.obj"));
+        Model* cube = models.back().get();
+
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        float halfWidth = 0.5f * (side - 1) * CUBE_SPACING;
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec3 position{(i % side) * CUBE_SPACING - halfWidth, 0.f, (i / side) * CUBE_SPACING - halfWidth};
+            Entity entity = addObject(registry, sceneGraph, cube, position, 0.08f);
+            if (i % 2 == 0) {
+                registry.add<SpinComponent>(entity, {0.5f + (i % 7) * 0.25f});
+            }
+        }
+        addRingLights(registry, sceneGraph, halfWidth, 1.f, 8);
+
+        float radius = halfWidth + 3.f;
+        return CameraPath::orbit(glm::vec3{0.f}, radius, radius * 0.5f, BENCHMARK_ORBIT_SECONDS);
+    }
+
+    CameraPath createLights(uint32_t count, Device& device, Registry& registry, SceneGraph& sceneGraph, std::vector<std::unique_ptr<Model>>& models) {
+        auto loaded = Model::createModelsFromFiles(device, {
+            "../models/quad.obj",
+            "../models/stormtrooper.obj",
+            "../models/smooth_vase.obj"
+        });
+        addObject(registry, sceneGraph, loaded[0].get(), {0.f, 0.5f, 0.f}, 6.f);
+        Entity stormtrooper = addObject(registry, sceneGraph, loaded[1].get(), {0.f, 0.5f, 0.f}, 1.f);
+        registry.add<SpinComponent>(stormtrooper);
+        addObject(registry, sceneGraph, loaded[2].get(), {-2.f, 0.5f, 0.f}, 4.f);
+        for (auto& model : loaded) {
+            models.push_back(std::move(model));
+        }
+
+        std::mt19937 random{BENCHMARK_SEED};
+        std::uniform_real_distribution<float> unit{0.f, 1.f};
+        Entity pivot = addLightPivot(registry, sceneGraph, -0.3f);
+        for (uint32_t i = 0; i < count; i++) {
+            // uniform over a disc above the floor
+            float radius = 5.f * std::sqrt(unit(random));
+            float angle = glm::two_pi<float>() * unit(random);
+            glm::vec3 position{std::sin(angle) * radius, -0.2f - 1.3f * unit(random), std::cos(angle) * radius};
+            glm::vec3 color{0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random)};
+            addLight(registry, sceneGraph, pivot, position, color, 0.2f);
+        }
+
+        return CameraPath::orbit(glm::vec3{0.f}, 7.f, 3.f, BENCHMARK_ORBIT_SECONDS);
+    }
+
+    CameraPath createMeshes(uint32_t count, Device& device, Registry& registry, SceneGraph& sceneGraph, std::vector<std::unique_ptr<Model>>& models) {
+        // building the vertex data dominates, buffers are created afterwards on this thread
+        std::vector<Model::Builder> builders(count);
+        JobSystem::shared().parallelFor(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                float hue = static_cast<float>(i) / count;
+                glm::vec3 color{0.5f + 0.5f * std::cos(glm::two_pi<float>() * hue), 0.5f + 0.5f * std::cos(glm::two_pi<float>() * (hue + 0.33f)), 0.5f + 0.5f * std::cos(glm::two_pi<float>() * (hue + 0.67f))};
+                builders[i] = createSphere(SPHERE_RINGS, SPHERE_SEGMENTS, color);
+            }
+        });
+
+        float ringRadius = std::max(2.f, count * 0.35f);
+        for (uint32_t i = 0; i < count; i++) {
+            models.push_back(std::make_unique<Model>(device, builders[i]));
+            float angle = i * glm::two_pi<float>() / count;
+            Entity entity = addObject(registry, sceneGraph, models.back().get(), {std::sin(angle) * ringRadius, 0.f, std::cos(angle) * ringRadius}, 0.8f);
+            registry.add<SpinComponent>(entity);
+        }
+        addRingLights(registry, sceneGraph, ringRadius, 1.5f, 6);
+
+        float radius = ringRadius + 4.f;
+        return CameraPath::orbit(glm::vec3{0.f}, radius, radius * 0.4f, BENCHMARK_ORBIT_SECONDS);
+    }
+}
+
+bool parseBenchmarkScene(const std::string& name, BenchmarkScene& scene) {
+    for (BenchmarkScene candidate : {BenchmarkScene::Cubes, BenchmarkScene::Lights, BenchmarkScene::Meshes}) {
+        if (name == benchmarkSceneName(candidate)) {
+            scene = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* benchmarkSceneName(BenchmarkScene scene) {
+    switch (scene) {
+        case BenchmarkScene::Cubes: return "cubes";
+        case BenchmarkScene::Lights: return "lights";
+        case BenchmarkScene::Meshes: return "meshes";
+    }
+    return "unknown";
+}
+
+CameraPath createBenchmarkScene(
+    BenchmarkScene scene,
+    uint32_t count,
+    Device& device,
+    Registry& registry,
+    SceneGraph& sceneGraph,
+    std::vector<std::unique_ptr<Model>>& models) {
+    switch (scene) {
+        case BenchmarkScene::Cubes:
+            return createCubes(count ? count : DEFAULT_CUBE_COUNT, device, registry, sceneGraph, models);
+        case BenchmarkScene::Lights:
+            return createLights(count ? count : DEFAULT_LIGHT_COUNT, device, registry, sceneGraph, models);
+        case BenchmarkScene::Meshes:
+            return createMeshes(count ? count : DEFAULT_MESH_COUNT, device, registry, sceneGraph, models);
+    }
+    throw std::runtime_error("Unknown benchmark scene");
+}
+
+BenchmarkRecorder::BenchmarkRecorder(bool enabled, uint32_t warmupFrames) : enabled{enabled}, warmupFrames{warmupFrames} {}
+
+void BenchmarkRecorder::endFrame() {
+    if (!enabled) return;
+    // warmup frames pay for pipeline creation, first uploads and cold caches
+    if (framesSeen++ < warmupFrames) return;
+
+    frameTimes.push_back(std::chrono::duration<float, std::milli>(lastLap - frameStart).count());
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        phaseTimes[phase].push_back(currentPhases[phase]);
+    }
+}
+
+void BenchmarkRecorder::writeJson(std::ostream& out, const BenchmarkInfo& info) const {
+    std::vector<float> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t residentKb, peakKb;
+    processMemory(residentKb, peakKb);
+
+    out << std::fixed << std::setprecision(4);
+    out << "{\n";
+    out << "  \"scene\": " << jsonString(info.scene) << ",\n";
+    out << "  \"renderPath\": " << jsonString(info.renderPath) << ",\n";
+    out << "  \"device\": " << jsonString(info.device) << ",\n";
+    out << "  \"width\": " << info.extent.width << ",\n";
+    out << "  \"height\": " << info.extent.height << ",\n";
+    out << "  \"objects\": " << info.objectCount << ",\n";
+    out << "  \"lights\": " << info.lightCount << ",\n";
+    out << "  \"warmupFrames\": " << warmupFrames << ",\n";
+    out << "  \"frames\": " << frameTimes.size() << ",\n";
+    out << "  \"frameTimeMs\": {\"mean\": " << mean(frameTimes)
+        << ", \"min\": " << (sorted.empty() ? 0.f : sorted.front())
+        << ", \"max\": " << (sorted.empty() ? 0.f : sorted.back())
+        << ", \"p50\": " << percentile(sorted, 50.f)
+        << ", \"p95\": " << percentile(sorted, 95.f)
+        << ", \"p99\": " << percentile(sorted, 99.f) << "},\n";
+    out << "  \"phasesMs\": {\n";
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        std::vector<float> phaseSorted = phaseTimes[phase];
+        std::sort(phaseSorted.begin(), phaseSorted.end());
+        out << "    \"" << phaseName(phase) << "\": {\"mean\": " << mean(phaseTimes[phase])
+            << ", \"p95\": " << percentile(phaseSorted, 95.f) << "}"
+            << (phase + 1 < PHASE_COUNT ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    out << "  \"memoryKb\": {\"resident\": " << residentKb << ", \"peakResident\": " << peakKb << "}\n";
+    out << "}\n";
+}
+
+void BenchmarkRecorder::printSummary(std::ostream& out) const {
+    std::vector<float> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    out << std::fixed << std::setprecision(3)
+        << "benchmark: " << frameTimes.size() << " frames, mean " << mean(frameTimes)
+        << " ms, p50 " << percentile(sorted, 50.f)
+        << " ms, p95 " << percentile(sorted, 95.f)
+        << " ms, p99 " << percentile(sorted, 99.f) << " ms\n";
+    out << std::defaultfloat;
+}
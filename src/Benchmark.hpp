@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CameraPath.hpp"
+#include "Device.hpp"
+#include "Model.hpp"
+#include "Registry.hpp"
+#include "SceneGraph.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Stress scenes for repeatable performance numbers, each scales with a count
+enum class BenchmarkScene {
+    Cubes, // many small objects sharing one model, half of them spinning
+    Lights, // a few models under many orbiting point lights
+    Meshes // a handful of high polygon meshes
+};
+
+bool parseBenchmarkScene(const std::string& name, BenchmarkScene& scene);
+const char* benchmarkSceneName(BenchmarkScene scene);
+
+// Populates registry and sceneGraph with the scene and returns the camera path that flies
+// through it. count 0 picks the scene's default size. Created models are appended to models.
+CameraPath createBenchmarkScene(
+    BenchmarkScene scene,
+    uint32_t count,
+    Device& device,
+    Registry& registry,
+    SceneGraph& sceneGraph,
+    std::vector<std::unique_ptr<Model>>& models);
+
+// Parts of a frame on the render thread, in the order they run
+enum class BenchmarkPhase {
+    Input,
+    Simulation,
+    Acquire, // includes the wait on the frame's fence, so GPU bound runs show up here
+    Update,
+    Record,
+    Submit, // includes present
+    Count
+};
+
+struct BenchmarkInfo {
+    std::string scene;
+    std::string renderPath;
+    std::string device;
+    VkExtent2D extent;
+    size_t objectCount;
+    size_t lightCount;
+};
+
+// Collects per frame and per phase CPU times. Each lap charges the time since the previous lap
+// to a phase, so timing a frame costs one clock read per phase. Disabled recorders do nothing.
+class BenchmarkRecorder {
+    public:
+        explicit BenchmarkRecorder(bool enabled, uint32_t warmupFrames = 0);
+
+        void beginFrame() {
+            if (!enabled) return;
+            frameStart = lastLap = Clock::now();
+            currentPhases.fill(0.f);
+        }
+        void lap(BenchmarkPhase phase) {
+            if (!enabled) return;
+            auto now = Clock::now();
+            currentPhases[static_cast<size_t>(phase)] += std::chrono::duration<float, std::milli>(now - lastLap).count();
+            lastLap = now;
+        }
+        // Frames that were begun but never ended, e.g. skipped while minimized, are dropped
+        void endFrame();
+
+        size_t recordedFrames() const { return frameTimes.size(); }
+
+        // Frame time mean and p50 / p95 / p99, per phase mean and p95, and process memory
+        void writeJson(std::ostream& out, const BenchmarkInfo& info) const;
+        void printSummary(std::ostream& out) const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        static constexpr size_t PHASE_COUNT = static_cast<size_t>(BenchmarkPhase::Count);
+
+        bool enabled;
+        uint32_t warmupFrames;
+        uint32_t framesSeen{0};
+        Clock::time_point frameStart{};
+        Clock::time_point lastLap{};
+        std::array<float, PHASE_COUNT> currentPhases{};
+
+        std::vector<float> frameTimes;
+        std::array<std::vector<float>, PHASE_COUNT> phaseTimes;
+};
@@ -0,0 +1,122 @@
+#include "BindlessDescriptors.hpp"
+#include "SwapChain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+// upper bounds on the array sizes, the device limits may lower them further
+#define BINDLESS_MAX_SAMPLED_IMAGES 4096u
+#define BINDLESS_MAX_STORAGE_BUFFERS 4096u
+
+// slots can be written while unused by pending frames and left empty when nothing uses them
+#define BINDLESS_BINDING_FLAGS \
+    (VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | \
+     VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT)
+
+BindlessDescriptors::BindlessDescriptors(Device& device) {
+    if (!device.supportsDescriptorIndexing()) {
+        throw std::runtime_error("Bindless descriptors need descriptor indexing, which the device does not support");
+    }
+    auto& limits = device.descriptorIndexingProperties();
+    // combined image samplers count against both the sampler and the sampled image limits
+    sampledImages.capacity = std::min({
+        BINDLESS_MAX_SAMPLED_IMAGES,
+        limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        limits.maxDescriptorSetUpdateAfterBindSampledImages,
+        limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+        limits.maxDescriptorSetUpdateAfterBindSamplers});
+    storageBuffers.capacity = std::min({
+        BINDLESS_MAX_STORAGE_BUFFERS,
+        limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+        limits.maxDescriptorSetUpdateAfterBindStorageBuffers});
+
+    VkShaderStageFlags stages = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+    setLayout = DescriptorSetLayout::Builder(device)
+        .addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stages, sampledImages.capacity, BINDLESS_BINDING_FLAGS)
+        .addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages, storageBuffers.capacity, BINDLESS_BINDING_FLAGS)
+        .build();
+    pool = DescriptorPool::Builder(device)
+        .setMaxSets(1)
+        .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampledImages.capacity)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers.capacity)
+        .build();
+    if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet)) {
+        throw std::runtime_error("Failed to allocate bindless descriptor set");
+    }
+}
+
+uint32_t BindlessDescriptors::addSampledImage(const VkDescriptorImageInfo& imageInfo) {
+    uint32_t index = sampledImages.allocate("sampled image");
+    updateSampledImage(index, imageInfo);
+    return index;
+}
+
+void BindlessDescriptors::updateSampledImage(uint32_t index, const VkDescriptorImageInfo& imageInfo) {
+    assert(index < sampledImages.next && "Sampled image index was never allocated");
+    VkDescriptorImageInfo info = imageInfo;
+    DescriptorWriter(*setLayout, *pool)
+        .writeImage(SAMPLED_IMAGE_BINDING, &info, index)
+        .overwrite(descriptorSet);
+}
+
+void BindlessDescriptors::releaseSampledImage(uint32_t index) {
+    sampledImages.release(index, frameCount);
+}
+
+uint32_t BindlessDescriptors::addStorageBuffer(const VkDescriptorBufferInfo& bufferInfo) {
+    uint32_t index = storageBuffers.allocate("storage buffer");
+    updateStorageBuffer(index, bufferInfo);
+    return index;
+}
+
+void BindlessDescriptors::updateStorageBuffer(uint32_t index, const VkDescriptorBufferInfo& bufferInfo) {
+    assert(index < storageBuffers.next && "Storage buffer index was never allocated");
+    VkDescriptorBufferInfo info = bufferInfo;
+    DescriptorWriter(*setLayout, *pool)
+        .writeBuffer(STORAGE_BUFFER_BINDING, &info, index)
+        .overwrite(descriptorSet);
+}
+
+void BindlessDescriptors::releaseStorageBuffer(uint32_t index) {
+    storageBuffers.release(index, frameCount);
+}
+
+void BindlessDescriptors::beginFrame() {
+    frameCount++;
+    sampledImages.recycle(frameCount);
+    storageBuffers.recycle(frameCount);
+}
+
+uint32_t BindlessDescriptors::IndexAllocator::allocate(const char* kind) {
+    if (!freeIndices.empty()) {
+        uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+        return index;
+    }
+    if (next == capacity) {
+        throw std::runtime_error(std::string("Bindless table is out of ") + kind + " slots");
+    }
+    return next++;
+}
+
+void BindlessDescriptors::IndexAllocator::release(uint32_t index, uint64_t frame) {
+    assert(index < next && "Releasing a bindless index that was never allocated");
+    retired.push_back({index, frame});
+}
+
+void BindlessDescriptors::IndexAllocator::recycle(uint64_t frame) {
+    // a frame waits for the fence of the frame MAX_FRAMES_IN_FLIGHT before it, so by then every
+    // frame recorded while the index was live has completed
+    size_t kept = 0;
+    for (auto& entry : retired) {
+        if (frame >= entry.frame + SwapChain::MAX_FRAMES_IN_FLIGHT) {
+            freeIndices.push_back(entry.index);
+        } else {
+            retired[kept++] = entry;
+        }
+    }
+    retired.resize(kept);
+}
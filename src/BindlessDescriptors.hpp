@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Descriptors.hpp"
+#include "Device.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One descriptor set holding large arrays of every sampled image and storage buffer, bound once
+// and indexed by shaders with indices passed through push constants. The arrays are partially
+// bound and updated after bind, so slots are filled and released while frames are in flight.
+// Layout, which shaders declare as runtime arrays in the set they bind it to:
+//   binding 0: combined image samplers
+//   binding 1: storage buffers
+class BindlessDescriptors {
+    public:
+        static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+        static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        // Needs Device::supportsDescriptorIndexing
+        BindlessDescriptors(Device& device);
+
+        BindlessDescriptors(const BindlessDescriptors&) = delete;
+        BindlessDescriptors& operator=(const BindlessDescriptors&) = delete;
+
+        // Indices stay valid until released, updating one rewrites the descriptor in place
+        uint32_t addSampledImage(const VkDescriptorImageInfo& imageInfo);
+        void updateSampledImage(uint32_t index, const VkDescriptorImageInfo& imageInfo);
+        void releaseSampledImage(uint32_t index);
+
+        uint32_t addStorageBuffer(const VkDescriptorBufferInfo& bufferInfo);
+        void updateStorageBuffer(uint32_t index, const VkDescriptorBufferInfo& bufferInfo);
+        void releaseStorageBuffer(uint32_t index);
+
+        // Released indices are handed out again once every frame that could still read them has
+        // finished, call once per frame after Renderer::beginFrame
+        void beginFrame();
+
+        VkDescriptorSetLayout getSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+        VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+        uint32_t getSampledImageCapacity() const { return sampledImages.capacity; }
+        uint32_t getStorageBufferCapacity() const { return storageBuffers.capacity; }
+
+    private:
+        // Free list over [0, capacity), indices released in a frame wait out the frames in flight
+        struct IndexAllocator {
+            struct Retired {
+                uint32_t index;
+                uint64_t frame;
+            };
+
+            uint32_t capacity{0};
+            uint32_t next{0};
+            std::vector<uint32_t> freeIndices;
+            std::vector<Retired> retired;
+
+            uint32_t allocate(const char* kind);
+            void release(uint32_t index, uint64_t frame);
+            void recycle(uint64_t frame);
+        };
+
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        std::unique_ptr<DescriptorPool> pool;
+        VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+
+        IndexAllocator sampledImages;
+        IndexAllocator storageBuffers;
+        uint64_t frameCount{0};
+};
@@ -7,8 +7,13 @@
 #include "Buffer.hpp"
  
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+
+// mappable uniform and storage buffers up to this size prefer device local memory (BAR),
+// larger ones would eat into a heap that is often only 256MB
+#define BAR_PREFERRED_MAX_SIZE (4 * 1024 * 1024)
  
 /**
  * Returns the minimum instance size required to be compatible with devices minOffsetAlignment
@@ -38,13 +43,32 @@ Buffer::Buffer(
       memoryPropertyFlags{memoryPropertyFlags} {
   alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
   bufferSize = alignmentSize * instanceCount;
-  device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+  nonCoherentAtomSize = std::max<VkDeviceSize>(1, device.properties.limits.nonCoherentAtomSize);
+
+  // mapped memory is preferably coherent, which makes flushes free. Buffers the GPU reads
+  // straight from the mapping also prefer being device local.
+  VkMemoryPropertyFlags preferredFlags = 0;
+  if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    preferredFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if ((usageFlags & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) &&
+        bufferSize <= BAR_PREFERRED_MAX_SIZE) {
+      preferredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+  }
+  device.createBuffer(
+      bufferSize,
+      usageFlags,
+      memoryPropertyFlags,
+      buffer,
+      memory,
+      preferredFlags,
+      &this->memoryPropertyFlags);
 }
  
 Buffer::~Buffer() {
   unmap();
   vkDestroyBuffer(device.device(), buffer, nullptr);
-  vkFreeMemory(device.device(), memory, nullptr);
+  device.freeMemory(memory);
 }
  
 /**
@@ -72,6 +96,7 @@ void Buffer::unmap() {
  
 /**
  * Copies the specified data to the mapped buffer. Default value writes whole buffer range
+ * @note Writes to non-coherent memory are recorded as dirty until the next flush()
  * @param data Pointer to the data to copy
  * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to flush the complete buffer
  * range.
@@ -82,27 +107,107 @@ void Buffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
  
   if (size == VK_WHOLE_SIZE) {
     memcpy(mapped, data, bufferSize);
+    markDirty(0, bufferSize);
   } else {
     char *memOffset = (char *)mapped;
     memOffset += offset;
     memcpy(memOffset, data, size);
+    markDirty(offset, offset + size);
+  }
+}
+
+/**
+ * Records a written byte range of non-coherent memory, extending the last range when the write
+ * continues or overlaps it
+ * @param begin First byte written
+ * @param end One past the last byte written
+ */
+void Buffer::markDirty(VkDeviceSize begin, VkDeviceSize end) {
+  if (isCoherent() || begin >= end) return;
+  if (!dirtyRanges.empty()) {
+    DirtyRange &last = dirtyRanges.back();
+    if (begin <= last.end && end >= last.begin) {
+      last.begin = std::min(last.begin, begin);
+      last.end = std::max(last.end, end);
+      return;
+    }
   }
+  dirtyRanges.push_back({begin, end});
+}
+
+/**
+ * Widens a byte range to multiples of nonCoherentAtomSize, as flushes and invalidations require
+ * @param begin First byte of the range
+ * @param end One past the last byte of the range, or VK_WHOLE_SIZE
+ * @return Range rounded outwards, reaching to the end of the allocation when rounding up would
+ * pass the end of the buffer
+ */
+VkMappedMemoryRange Buffer::atomAlignedRange(VkDeviceSize begin, VkDeviceSize end) const {
+  VkMappedMemoryRange mappedRange = {};
+  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  mappedRange.memory = memory;
+  mappedRange.offset = begin - begin % nonCoherentAtomSize;
+  if (end == VK_WHOLE_SIZE || end > bufferSize - bufferSize % nonCoherentAtomSize) {
+    // the allocation may be larger than the buffer, only VK_WHOLE_SIZE is sure to stay inside it
+    mappedRange.size = VK_WHOLE_SIZE;
+  } else {
+    VkDeviceSize alignedEnd = (end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+    mappedRange.size = alignedEnd - mappedRange.offset;
+  }
+  return mappedRange;
+}
+
+/**
+ * Flushes every range written since the last flush, merging ranges that share an atom into a
+ * single flush call
+ * @return VkResult of the flush call
+ */
+VkResult Buffer::flushDirtyRanges() {
+  if (dirtyRanges.empty()) return VK_SUCCESS;
+
+  std::sort(dirtyRanges.begin(), dirtyRanges.end(), [](const DirtyRange &a, const DirtyRange &b) {
+    return a.begin < b.begin;
+  });
+  std::vector<VkMappedMemoryRange> mappedRanges;
+  for (const DirtyRange &range : dirtyRanges) {
+    VkMappedMemoryRange aligned = atomAlignedRange(range.begin, range.end);
+    if (!mappedRanges.empty()) {
+      VkMappedMemoryRange &last = mappedRanges.back();
+      if (last.size == VK_WHOLE_SIZE) break;
+      if (aligned.offset <= last.offset + last.size) {
+        last.size = aligned.size == VK_WHOLE_SIZE
+                        ? VK_WHOLE_SIZE
+                        : std::max(last.offset + last.size, aligned.offset + aligned.size) - last.offset;
+        continue;
+      }
+    }
+    mappedRanges.push_back(aligned);
+  }
+  dirtyRanges.clear();
+  return vkFlushMappedMemoryRanges(
+      device.device(),
+      static_cast<uint32_t>(mappedRanges.size()),
+      mappedRanges.data());
 }
  
 /**
  * Flush a memory range of the buffer to make it visible to the device
- * @note Only required for non-coherent memory
- * @param size (Optional) Size of the memory range to flush. Pass VK_WHOLE_SIZE to flush the
- * complete buffer range.
+ * @note Only required for non-coherent memory, a no-op for coherent memory. The range is widened
+ * to multiples of nonCoherentAtomSize and assumes the whole buffer is mapped.
+ * @param size (Optional) Size of the memory range to flush. Pass VK_WHOLE_SIZE with offset 0 to
+ * flush only the ranges written by writeToBuffer since the last flush.
  * @param offset (Optional) Byte offset from beginning
  * @return VkResult of the flush call
  */
 VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
+  if (isCoherent()) {
+    return VK_SUCCESS;
+  }
+  if (size == VK_WHOLE_SIZE && offset == 0) {
+    return flushDirtyRanges();
+  }
+  VkMappedMemoryRange mappedRange =
+      atomAlignedRange(offset, size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : offset + size);
   return vkFlushMappedMemoryRanges(device.device(), 1, &mappedRange);
 }
  
@@ -115,11 +220,11 @@ VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
  * @return VkResult of the invalidate call
  */
 VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
+  if (isCoherent()) {
+    return VK_SUCCESS;
+  }
+  VkMappedMemoryRange mappedRange =
+      atomAlignedRange(offset, size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : offset + size);
   return vkInvalidateMappedMemoryRanges(device.device(), 1, &mappedRange);
 }
  
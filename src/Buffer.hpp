@@ -1,6 +1,9 @@
 #pragma once
  
 #include "Device.hpp"
+
+// std
+#include <vector>
  
 class Buffer {
  public:
@@ -19,7 +22,9 @@ class Buffer {
   VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   void unmap();
  
+  // Writes to non-coherent memory are remembered until the next flush
   void writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+  // Without arguments only the ranges written since the last flush are flushed
   VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -35,11 +40,21 @@ class Buffer {
   VkDeviceSize getInstanceSize() const { return instanceSize; }
   VkDeviceSize getAlignmentSize() const { return instanceSize; }
   VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
+  // Every property of the memory type backing the buffer, which may exceed the requested ones
   VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
+  bool isCoherent() const { return memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
   VkDeviceSize getBufferSize() const { return bufferSize; }
  
  private:
+  struct DirtyRange {
+    VkDeviceSize begin;
+    VkDeviceSize end;
+  };
+
   static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+  void markDirty(VkDeviceSize begin, VkDeviceSize end);
+  VkMappedMemoryRange atomAlignedRange(VkDeviceSize begin, VkDeviceSize end) const;
+  VkResult flushDirtyRanges();
  
   Device& device;
   void* mapped = nullptr;
@@ -52,4 +67,6 @@ class Buffer {
   VkDeviceSize alignmentSize;
   VkBufferUsageFlags usageFlags;
   VkMemoryPropertyFlags memoryPropertyFlags;
+  VkDeviceSize nonCoherentAtomSize;
+  std::vector<DirtyRange> dirtyRanges;
 };
\ No newline at end of file
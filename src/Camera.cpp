@@ -12,6 +12,8 @@ void Camera::setOrthographicProjection(
     projectionMatrix[3][0] = -(right + left) / (right - left);
     projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
     projectionMatrix[3][2] = -near / (far - near);
+    nearPlane = near;
+    farPlane = far;
 }
  
 void Camera::setPerspectiveProjection(float fovy, float aspect, float near, float far) {
@@ -23,6 +25,8 @@ void Camera::setPerspectiveProjection(float fovy, float aspect, float near, floa
     projectionMatrix[2][2] = far / (far - near);
     projectionMatrix[2][3] = 1.f;
     projectionMatrix[3][2] = -(far * near) / (far - near);
+    nearPlane = near;
+    farPlane = far;
 }
 
 void Camera::setViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) {
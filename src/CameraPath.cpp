@@ -0,0 +1,106 @@
+#include "CameraPath.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+// keyframes generated per orbit, dense enough that the spline stays close to the circle
+#define ORBIT_KEYFRAMES 64
+
+namespace {
+    glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * ((2.f * p1) + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+    }
+
+    float lerpAngle(float from, float to, float t) {
+        float delta = glm::mod(to - from + glm::pi<float>(), glm::two_pi<float>()) - glm::pi<float>();
+        return from + delta * t;
+    }
+}
+
+void CameraPath::addKeyframe(float time, const glm::vec3& translation, const glm::vec3& rotation) {
+    assert((keyframes.empty() || time >= keyframes.back().time) && "Camera path keyframes must be added in order");
+    keyframes.push_back({time, translation, rotation});
+}
+
+void CameraPath::sample(float time, TransformComponent& transform) const {
+    if (keyframes.empty()) return;
+    if (keyframes.size() == 1 || duration() <= 0.f) {
+        transform.translation = keyframes[0].translation;
+        transform.rotation = keyframes[0].rotation;
+        return;
+    }
+
+    time = std::fmod(time, duration());
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float t, const Keyframe& key) {
+        return t < key.time;
+    });
+    size_t i1 = std::min(static_cast<size_t>(next - keyframes.begin()), keyframes.size() - 1);
+    size_t i0 = i1 - 1;
+    const Keyframe& from = keyframes[i0];
+    const Keyframe& to = keyframes[i1];
+    float span = to.time - from.time;
+    float t = span > 0.f ? (time - from.time) / span : 1.f;
+
+    // end points repeat themselves, so the spline does not overshoot at either end
+    const glm::vec3& before = keyframes[i0 > 0 ? i0 - 1 : i0].translation;
+    const glm::vec3& after = keyframes[std::min(i1 + 1, keyframes.size() - 1)].translation;
+    transform.translation = catmullRom(before, from.translation, to.translation, after, t);
+    transform.rotation = {
+        lerpAngle(from.rotation.x, to.rotation.x, t),
+        lerpAngle(from.rotation.y, to.rotation.y, t),
+        lerpAngle(from.rotation.z, to.rotation.z, t)};
+}
+
+void CameraPath::save(const std::string& path) const {
+    std::ofstream file{path};
+    if (!file) {
+        throw std::runtime_error("Failed to open camera path " + path + " for writing");
+    }
+    for (const auto& key : keyframes) {
+        file << key.time << " "
+            << key.translation.x << " " << key.translation.y << " " << key.translation.z << " "
+            << key.rotation.x << " " << key.rotation.y << " " << key.rotation.z << "\n";
+    }
+}
+
+CameraPath CameraPath::load(const std::string& path) {
+    std::ifstream file{path};
+    if (!file) {
+        throw std::runtime_error("Failed to open camera path " + path);
+    }
+    CameraPath cameraPath{};
+    Keyframe key{};
+    while (file >> key.time >> key.translation.x >> key.translation.y >> key.translation.z
+            >> key.rotation.x >> key.rotation.y >> key.rotation.z) {
+        if (!cameraPath.keyframes.empty() && key.time < cameraPath.keyframes.back().time) {
+            throw std::runtime_error("Camera path " + path + " has keyframes out of order");
+        }
+        cameraPath.keyframes.push_back(key);
+    }
+    if (cameraPath.keyframes.empty()) {
+        throw std::runtime_error("Camera path " + path + " has no keyframes");
+    }
+    return cameraPath;
+}
+
+CameraPath CameraPath::orbit(const glm::vec3& target, float radius, float height, float duration) {
+    CameraPath cameraPath{};
+    for (int i = 0; i <= ORBIT_KEYFRAMES; i++) {
+        float t = static_cast<float>(i) / ORBIT_KEYFRAMES;
+        float angle = t * glm::two_pi<float>();
+        // -y is up, so a positive height lifts the camera above the target
+        glm::vec3 position = target + glm::vec3{std::sin(angle) * radius, -height, -std::cos(angle) * radius};
+        glm::vec3 direction = glm::normalize(target - position);
+        // inverse of the forward vector setViewYXZ derives from pitch and yaw
+        glm::vec3 rotation{-std::asin(direction.y), std::atan2(direction.x, direction.z), 0.f};
+        cameraPath.addKeyframe(t * duration, position, rotation);
+    }
+    return cameraPath;
+}
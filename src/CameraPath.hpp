@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Viewer positions and rotations over time, played back to drive the camera the same way on
+// every run. Paths are recorded from the interactive viewer or generated, and stored as text
+// with one "time x y z pitch yaw roll" keyframe per line.
+class CameraPath {
+    public:
+        struct Keyframe {
+            float time;
+            glm::vec3 translation;
+            glm::vec3 rotation;
+        };
+
+        // Keyframes must be added in increasing time
+        void addKeyframe(float time, const glm::vec3& translation, const glm::vec3& rotation);
+        // Catmull-Rom through the positions, rotations blend along the shorter arc. The path
+        // loops once time passes the last keyframe.
+        void sample(float time, TransformComponent& transform) const;
+
+        bool empty() const { return keyframes.empty(); }
+        float duration() const { return keyframes.empty() ? 0.f : keyframes.back().time; }
+
+        void save(const std::string& path) const;
+        static CameraPath load(const std::string& path);
+        // Circles target once per duration at the given radius and height, facing target
+        static CameraPath orbit(const glm::vec3& target, float radius, float height, float duration);
+
+    private:
+        std::vector<Keyframe> keyframes;
+};
@@ -0,0 +1,117 @@
+#include "Components.hpp"
+#include "TransformBatch.hpp"
+#include "JobSystem.hpp"
+
+// stale transforms handed to each job, small batches are built on the calling thread
+#define MIN_TRANSFORMS_PER_JOB 4096
+
+TransformComponent::Stats TransformComponent::stats{};
+
+const glm::mat4& TransformComponent::mat4() {
+    updateCache();
+    return cachedMatrix;
+}
+
+const glm::mat3& TransformComponent::normalMatrix() {
+    updateCache();
+    return cachedNormalMatrix;
+}
+
+bool TransformComponent::cacheCurrent() const {
+    if (!cacheValid || useOrientation != cachedUseOrientation) return false;
+    if (translation != cachedTranslation || scale != cachedScale) return false;
+    return useOrientation ? orientation == cachedOrientation : rotation == cachedRotation;
+}
+
+void TransformComponent::updateCaches(std::vector<TransformComponent>& transforms) {
+    // quaternion transforms are cheap enough to rebuild in place, only Euler ones need the
+    // sin/cos of the batch kernel
+    std::vector<TransformComponent*> stale;
+    size_t recomputed = 0;
+    for (auto& transform : transforms) {
+        if (transform.cacheCurrent()) continue;
+        recomputed++;
+        if (transform.useOrientation) {
+            transform.storeCache(quatToMat3(transform.orientation));
+        } else {
+            stale.push_back(&transform);
+        }
+    }
+    stats.recomputed.fetch_add(recomputed, std::memory_order_relaxed);
+    if (stale.empty()) return;
+
+    JobSystem::shared().parallelFor(stale.size(), MIN_TRANSFORMS_PER_JOB, [&](size_t begin, size_t end) {
+        size_t count = end - begin;
+        TransformBatch batch;
+        batch.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            batch.set(i, stale[begin + i]->translation, stale[begin + i]->rotation, stale[begin + i]->scale);
+        }
+        std::vector<glm::mat4> modelMatrices(count);
+        std::vector<glm::mat3> normalMatrices(count);
+        computeTransforms(batch, modelMatrices.data(), normalMatrices.data());
+
+        for (size_t i = 0; i < count; i++) {
+            TransformComponent& transform = *stale[begin + i];
+            transform.cacheValid = true;
+            transform.version++;
+            transform.cachedTranslation = transform.translation;
+            transform.cachedRotation = transform.rotation;
+            transform.cachedUseOrientation = false;
+            transform.cachedScale = transform.scale;
+            transform.cachedMatrix = modelMatrices[i];
+            transform.cachedNormalMatrix = normalMatrices[i];
+        }
+    });
+}
+
+void TransformComponent::updateCache() {
+    if (cacheCurrent()) {
+        stats.reused.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    stats.recomputed.fetch_add(1, std::memory_order_relaxed);
+    if (useOrientation) {
+        storeCache(quatToMat3(orientation));
+        return;
+    }
+
+    const float c3 = glm::cos(rotation.z);
+    const float s3 = glm::sin(rotation.z);
+    const float c2 = glm::cos(rotation.x);
+    const float s2 = glm::sin(rotation.x);
+    const float c1 = glm::cos(rotation.y);
+    const float s1 = glm::sin(rotation.y);
+    storeCache(glm::mat3{
+        {c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1},
+        {c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3},
+        {c2 * s1, -s2, c1 * c2},
+    });
+}
+
+void TransformComponent::storeCache(const glm::mat3& rotationMatrix) {
+    cacheValid = true;
+    version++;
+    cachedTranslation = translation;
+    cachedScale = scale;
+    cachedUseOrientation = useOrientation;
+    if (useOrientation) {
+        cachedOrientation = orientation;
+    } else {
+        cachedRotation = rotation;
+    }
+
+    // columns scaled by scale for the model matrix and by its inverse for the normal matrix
+    const glm::vec3 invScale = 1.0f / scale;
+    cachedMatrix = glm::mat4{
+        glm::vec4{rotationMatrix[0] * scale.x, 0.f},
+        glm::vec4{rotationMatrix[1] * scale.y, 0.f},
+        glm::vec4{rotationMatrix[2] * scale.z, 0.f},
+        glm::vec4{translation, 1.f},
+    };
+    cachedNormalMatrix = glm::mat3{
+        rotationMatrix[0] * invScale.x,
+        rotationMatrix[1] * invScale.y,
+        rotationMatrix[2] * invScale.z,
+    };
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Model.hpp"
+#include "Quaternion.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct TransformComponent {
+    glm::vec3 translation{};
+    glm::vec3 scale{1.f, 1.f, 1.f};
+    glm::vec3 rotation{};
+    // Optional orientation used instead of rotation once useOrientation is set. Building the
+    // matrix from it needs no sin/cos, and it blends cleanly with quatNlerp / quatSlerp.
+    glm::quat orientation{glm::quat::wxyz(1.f, 0.f, 0.f, 0.f)};
+    bool useOrientation{false};
+
+    void setOrientation(const glm::quat& q) {
+        orientation = q;
+        useOrientation = true;
+    }
+    // Switches to the quaternion representation, keeping the current Euler rotation
+    void convertToOrientation() { setOrientation(quatFromEulerYXZ(rotation)); }
+
+    // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
+    // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
+    // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+    // Both are cached and only rebuilt when translation, rotation or scale differ from
+    // the values the cache was built from, so static transforms skip the sin/cos entirely
+    const glm::mat4& mat4();
+    const glm::mat3& normalMatrix();
+    // Bumped every time the cached matrices are rebuilt
+    uint64_t getVersion() const { return version; }
+
+    // Rebuilds every stale cache in one pass of the SIMD batch kernel, so later mat4() and
+    // normalMatrix() calls in the frame are cache hits
+    static void updateCaches(std::vector<TransformComponent>& transforms);
+
+    // Counts matrix requests served from the cache versus rebuilt, across all transforms
+    struct Stats {
+        std::atomic<uint64_t> recomputed{0};
+        std::atomic<uint64_t> reused{0};
+    };
+    static Stats stats;
+
+    private:
+        bool cacheCurrent() const;
+        void updateCache();
+        void storeCache(const glm::mat3& rotationMatrix);
+
+        bool cacheValid{false};
+        uint64_t version{0};
+        glm::vec3 cachedTranslation{};
+        glm::vec3 cachedScale{};
+        glm::vec3 cachedRotation{};
+        glm::quat cachedOrientation{};
+        bool cachedUseOrientation{false};
+        glm::mat4 cachedMatrix{1.f};
+        glm::mat3 cachedNormalMatrix{1.f};
+};
+
+// Non owning, models are owned by App for the lifetime of the scene
+struct ModelComponent {
+    Model* model = nullptr;
+};
+
+struct ColorComponent {
+    glm::vec3 color{1.f};
+};
+
+struct PointLightComponent {
+    float lightIntensity = 1.0f;
+    float radius = 0.1f; // size of the drawn billboard
+};
+
+// Entities that spin around their y axis, speed is in radians per second
+struct SpinComponent {
+    float speed = 0.5f;
+};
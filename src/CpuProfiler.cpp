@@ -0,0 +1,111 @@
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// events kept per thread, a power of two so the ring index is a mask
+#define PROFILER_RING_SIZE (1u << 16)
+
+namespace {
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    struct ThreadRing {
+        uint32_t threadId;
+        const char* threadName{nullptr};
+        std::unique_ptr<Event[]> events{new Event[PROFILER_RING_SIZE]};
+        // total events written, the writer publishes each event by advancing it
+        std::atomic<uint64_t> head{0};
+    };
+
+    // rings stay registered after their thread exits so its events still get exported
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+
+    // the lock is only taken once per thread, on its first event
+    ThreadRing& threadRing() {
+        thread_local std::shared_ptr<ThreadRing> ring = []() {
+            std::lock_guard<std::mutex> lock{ringsMutex};
+            auto created = std::make_shared<ThreadRing>();
+            created->threadId = static_cast<uint32_t>(rings.size());
+            rings.push_back(created);
+            return created;
+        }();
+        return *ring;
+    }
+
+    void writeString(std::ostream& out, const char* text) {
+        out << '"';
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+std::atomic<bool> CpuProfiler::enabledFlag{false};
+
+void CpuProfiler::setThreadName(const char* name) {
+    threadRing().threadName = name;
+}
+
+void CpuProfiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadRing& ring = threadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head & (PROFILER_RING_SIZE - 1)] = {name, start, end};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void CpuProfiler::writeChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock{ringsMutex};
+
+    // timestamps are written relative to the oldest event kept
+    uint64_t origin = UINT64_MAX;
+    for (auto& ring : rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+        for (uint64_t i = first; i < head; i++) {
+            origin = std::min(origin, ring->events[i & (PROFILER_RING_SIZE - 1)].start);
+        }
+    }
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool firstEntry = true;
+    auto separate = [&]() {
+        if (!firstEntry) out << ",\n";
+        firstEntry = false;
+    };
+
+    out << std::fixed << std::setprecision(3);
+    for (auto& ring : rings) {
+        if (ring->threadName) {
+            separate();
+            out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->threadId
+                << ", \"args\": {\"name\": ";
+            writeString(out, ring->threadName);
+            out << "}}";
+        }
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+        for (uint64_t i = first; i < head; i++) {
+            const Event& event = ring->events[i & (PROFILER_RING_SIZE - 1)];
+            // complete events, in microseconds
+            separate();
+            out << "{\"name\": ";
+            writeString(out, event.name);
+            out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->threadId
+                << ", \"ts\": " << (event.start - origin) / 1000.0
+                << ", \"dur\": " << (event.end - event.start) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    out << std::defaultfloat;
+}
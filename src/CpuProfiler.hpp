@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the enclosing scope under name, which must be a string literal. Building with
+// DISABLE_CPU_PROFILER compiles the zones out entirely.
+#ifdef DISABLE_CPU_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone, __LINE__){name}
+#endif
+
+// Scoped CPU zones recorded into a ring buffer per thread. Only the owning thread writes its
+// ring, so recording takes no locks. Each ring keeps the most recent events and wraps over the
+// oldest. While disabled a zone costs a single relaxed load.
+class CpuProfiler {
+    public:
+        class Zone {
+            public:
+                explicit Zone(const char* name)
+                    : name{isEnabled() ? name : nullptr}, start{this->name ? now() : 0} {}
+                ~Zone() {
+                    if (name) {
+                        record(name, start, now());
+                    }
+                }
+
+                Zone(const Zone&) = delete;
+                Zone& operator=(const Zone&) = delete;
+
+            private:
+                const char* name;
+                uint64_t start;
+        };
+
+        static void setEnabled(bool enabled) { enabledFlag.store(enabled, std::memory_order_relaxed); }
+        static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+
+        // Label for the calling thread's track in the trace, name must outlive the profiler
+        static void setThreadName(const char* name);
+
+        // Chrome trace event JSON, opens in chrome://tracing and ui.perfetto.dev. Rings are read
+        // without synchronizing against their writers, so call it while instrumented threads are
+        // idle, e.g. after the main loop.
+        static void writeChromeTrace(std::ostream& out);
+
+        // nanoseconds on a steady clock
+        static uint64_t now() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+    private:
+        static void record(const char* name, uint64_t start, uint64_t end);
+
+        static std::atomic<bool> enabledFlag;
+};
@@ -1,16 +1,21 @@
 #include "Descriptors.hpp"
  
 // std
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
+// pools stop doubling at this many sets
+#define DESCRIPTOR_ALLOCATOR_MAX_SETS 4096u
+
  
 // *************** Descriptor Set Layout Builder *********************
 DescriptorSetLayout::Builder &DescriptorSetLayout::Builder::addBinding(
     uint32_t binding,
     VkDescriptorType descriptorType,
     VkShaderStageFlags stageFlags,
-    uint32_t count) {
+    uint32_t count,
+    VkDescriptorBindingFlags flags) {
     assert(bindings.count(binding) == 0 && "Binding already in use");
     VkDescriptorSetLayoutBinding layoutBinding{};
     layoutBinding.binding = binding;
@@ -18,25 +23,49 @@ DescriptorSetLayout::Builder &DescriptorSetLayout::Builder::addBinding(
     layoutBinding.descriptorCount = count;
     layoutBinding.stageFlags = stageFlags;
     bindings[binding] = layoutBinding;
+    if (flags != 0) {
+        bindingFlags[binding] = flags;
+    }
     return *this;
 }
  
 std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const {
-    return std::make_unique<DescriptorSetLayout>(device, bindings);
+    return std::make_unique<DescriptorSetLayout>(device, bindings, bindingFlags);
 }
  
 
 // *************** Descriptor Set Layout *********************
-DescriptorSetLayout::DescriptorSetLayout(Device& device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings) : device{device}, bindings{bindings} {
+DescriptorSetLayout::DescriptorSetLayout(
+    Device& device,
+    std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+    std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags)
+    : device{device}, bindings{bindings} {
     std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+    // flags line up with setLayoutBindings
+    std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+    bool updateAfterBind = false;
     for (auto kv : bindings) {
         setLayoutBindings.push_back(kv.second);
+        auto flags = bindingFlags.find(kv.first);
+        setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+        updateAfterBind |= (setLayoutBindingFlags.back() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
     }
  
     VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
     descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
     descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    if (!bindingFlags.empty()) {
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+        descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+    }
+    if (updateAfterBind) {
+        descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    }
     
     if (vkCreateDescriptorSetLayout(
             device.device(),
@@ -106,8 +135,7 @@ bool DescriptorPool::allocateDescriptor(
     allocInfo.pSetLayouts = &descriptorSetLayout;
     allocInfo.descriptorSetCount = 1;
     
-    // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-    // a new pool whenever an old pool fills up. But this is beyond our current scope
+    // a full pool fails here, DescriptorAllocator chains new pools instead
     if (vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
         return false;
     }
@@ -127,24 +155,135 @@ void DescriptorPool::resetPool() {
 }
  
 
+// *************** Descriptor Allocator Builder *********************
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::addPoolRatio(
+    VkDescriptorType descriptorType, float ratio) {
+    ratios.push_back({descriptorType, ratio});
+    return *this;
+}
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::setPoolFlags(
+    VkDescriptorPoolCreateFlags flags) {
+    poolFlags = flags;
+    return *this;
+}
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::setInitialSets(uint32_t count) {
+    initialSets = count;
+    return *this;
+}
+
+std::unique_ptr<DescriptorAllocator> DescriptorAllocator::Builder::build() const {
+    return std::make_unique<DescriptorAllocator>(device, initialSets, poolFlags, ratios);
+}
+
+
+// *************** Descriptor Allocator *********************
+DescriptorAllocator::DescriptorAllocator(
+    Device &device,
+    uint32_t initialSets,
+    VkDescriptorPoolCreateFlags poolFlags,
+    const std::vector<PoolSizeRatio> &ratios)
+    : device{device}, poolFlags{poolFlags}, ratios{ratios}, setsPerPool{initialSets} {
+    assert(initialSets > 0 && "Descriptor allocator needs at least one set per pool");
+    currentPool = createPool(setsPerPool);
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    vkDestroyDescriptorPool(device.device(), currentPool, nullptr);
+    for (auto pool : fullPools) {
+        vkDestroyDescriptorPool(device.device(), pool, nullptr);
+    }
+    for (auto pool : readyPools) {
+        vkDestroyDescriptorPool(device.device(), pool, nullptr);
+    }
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) {
+    std::vector<VkDescriptorPoolSize> poolSizes{};
+    for (auto &ratio : ratios) {
+        uint32_t count = static_cast<uint32_t>(ratio.ratio * maxSets);
+        poolSizes.push_back({ratio.descriptorType, count > 0 ? count : 1});
+    }
+
+    VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+    descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    descriptorPoolInfo.pPoolSizes = poolSizes.data();
+    descriptorPoolInfo.maxSets = maxSets;
+    descriptorPoolInfo.flags = poolFlags;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device.device(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+    return pool;
+}
+
+void DescriptorAllocator::nextPool() {
+    fullPools.push_back(currentPool);
+    if (!readyPools.empty()) {
+        currentPool = readyPools.back();
+        readyPools.pop_back();
+        return;
+    }
+    setsPerPool = std::min(setsPerPool * 2, DESCRIPTOR_ALLOCATOR_MAX_SETS);
+    currentPool = createPool(setsPerPool);
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(const VkDescriptorSetLayout descriptorSetLayout) {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+    allocInfo.descriptorSetCount = 1;
+
+    VkDescriptorSet descriptor;
+    allocInfo.descriptorPool = currentPool;
+    VkResult result = vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptor);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        nextPool();
+        allocInfo.descriptorPool = currentPool;
+        result = vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptor);
+    }
+    // a fresh pool failing means the layout needs descriptors the ratios leave out
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor set!");
+    }
+    return descriptor;
+}
+
+void DescriptorAllocator::reset() {
+    vkResetDescriptorPool(device.device(), currentPool, 0);
+    for (auto pool : fullPools) {
+        vkResetDescriptorPool(device.device(), pool, 0);
+        readyPools.push_back(pool);
+    }
+    fullPools.clear();
+}
+
+
 // *************** Descriptor Writer *********************
 DescriptorWriter::DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool)
-    : setLayout{setLayout}, pool{pool} {}
+    : setLayout{setLayout}, pool{&pool} {}
+
+DescriptorWriter::DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorAllocator &allocator)
+    : setLayout{setLayout}, allocator{&allocator} {}
  
 DescriptorWriter &DescriptorWriter::writeBuffer(
-    uint32_t binding, VkDescriptorBufferInfo *bufferInfo) {
+    uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t arrayElement) {
     assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
     
     auto &bindingDescription = setLayout.bindings[binding];
     
     assert(
-        bindingDescription.descriptorCount == 1 &&
-        "Binding single descriptor info, but binding expects multiple");
+        arrayElement < bindingDescription.descriptorCount &&
+        "Array element is out of range for the binding");
     
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     write.descriptorType = bindingDescription.descriptorType;
     write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
     write.pBufferInfo = bufferInfo;
     write.descriptorCount = 1;
     
@@ -153,19 +292,20 @@ DescriptorWriter &DescriptorWriter::writeBuffer(
 }
  
 DescriptorWriter &DescriptorWriter::writeImage(
-    uint32_t binding, VkDescriptorImageInfo *imageInfo) {
+    uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t arrayElement) {
     assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
     
     auto &bindingDescription = setLayout.bindings[binding];
     
     assert(
-        bindingDescription.descriptorCount == 1 &&
-        "Binding single descriptor info, but binding expects multiple");
+        arrayElement < bindingDescription.descriptorCount &&
+        "Array element is out of range for the binding");
     
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     write.descriptorType = bindingDescription.descriptorType;
     write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
     write.pImageInfo = imageInfo;
     write.descriptorCount = 1;
     
@@ -174,7 +314,12 @@ DescriptorWriter &DescriptorWriter::writeImage(
 }
  
 bool DescriptorWriter::build(VkDescriptorSet &set) {
-    bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
+    if (allocator) {
+        set = allocator->allocate(setLayout.getDescriptorSetLayout());
+        overwrite(set);
+        return true;
+    }
+    bool success = pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
     if (!success) {
         return false;
     }
@@ -186,5 +331,5 @@ void DescriptorWriter::overwrite(VkDescriptorSet &set) {
     for (auto &write : writes) {
         write.dstSet = set;
     }
-    vkUpdateDescriptorSets(pool.device.device(), writes.size(), writes.data(), 0, nullptr);
+    vkUpdateDescriptorSets(setLayout.device.device(), writes.size(), writes.data(), 0, nullptr);
 }
\ No newline at end of file
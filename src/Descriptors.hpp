@@ -13,19 +13,26 @@ public:
         public:
         Builder(Device &device) : device{device} {}
  
+        // bindingFlags other than 0 need descriptor indexing. A binding that can be updated after
+        // bind makes the layout need a pool created with UPDATE_AFTER_BIND as well.
         Builder &addBinding(
             uint32_t binding,
             VkDescriptorType descriptorType,
             VkShaderStageFlags stageFlags,
-            uint32_t count = 1);
+            uint32_t count = 1,
+            VkDescriptorBindingFlags bindingFlags = 0);
         std::unique_ptr<DescriptorSetLayout> build() const;
  
     private:
         Device &device;
         std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
 };
  
-    DescriptorSetLayout(Device &Device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+    DescriptorSetLayout(
+        Device &Device,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags = {});
     ~DescriptorSetLayout();
     DescriptorSetLayout(const DescriptorSetLayout &) = delete;
     DescriptorSetLayout &operator=(const DescriptorSetLayout &) = delete;
@@ -80,19 +87,81 @@ private:
     
     friend class DescriptorWriter;
 };
+
+// Hands out sets from a chain of pools sized by descriptors per set ratios. When a pool runs
+// out or fragments another one twice its size is created, so allocations only fail for layouts
+// the ratios don't cover. reset() recycles every pool at once, which suits per-frame sets.
+class DescriptorAllocator {
+public:
+    struct PoolSizeRatio {
+        VkDescriptorType descriptorType;
+        float ratio;
+    };
+
+    class Builder {
+    public:
+        Builder(Device &device) : device{device} {}
+
+        // ratio descriptors of this type per set, e.g. 2 for a layout with two storage buffers
+        Builder &addPoolRatio(VkDescriptorType descriptorType, float ratio);
+        Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+        Builder &setInitialSets(uint32_t count);
+        std::unique_ptr<DescriptorAllocator> build() const;
+
+    private:
+        Device &device;
+        std::vector<PoolSizeRatio> ratios{};
+        uint32_t initialSets = 64;
+        VkDescriptorPoolCreateFlags poolFlags = 0;
+    };
+
+    DescriptorAllocator(
+        Device &device,
+        uint32_t initialSets,
+        VkDescriptorPoolCreateFlags poolFlags,
+        const std::vector<PoolSizeRatio> &ratios);
+    ~DescriptorAllocator();
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+    VkDescriptorSet allocate(const VkDescriptorSetLayout descriptorSetLayout);
+
+    // Every set allocated so far becomes invalid, the GPU must be done with them
+    void reset();
+
+    size_t getPoolCount() const { return fullPools.size() + readyPools.size() + 1; }
+
+private:
+    VkDescriptorPool createPool(uint32_t maxSets);
+    void nextPool();
+
+    Device &device;
+    VkDescriptorPoolCreateFlags poolFlags;
+    std::vector<PoolSizeRatio> ratios;
+    uint32_t setsPerPool;
+    VkDescriptorPool currentPool = VK_NULL_HANDLE;
+    // pools that ran out since the last reset, and empty ones waiting to be used again
+    std::vector<VkDescriptorPool> fullPools;
+    std::vector<VkDescriptorPool> readyPools;
+};
  
 class DescriptorWriter {
     public:
         DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool);
+        DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorAllocator &allocator);
         
-        DescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
-        DescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+        // arrayElement picks the descriptor to write in bindings with a count above one
+        DescriptorWriter &writeBuffer(
+            uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t arrayElement = 0);
+        DescriptorWriter &writeImage(
+            uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t arrayElement = 0);
         
         bool build(VkDescriptorSet &set);
         void overwrite(VkDescriptorSet &set);
     
     private:
         DescriptorSetLayout &setLayout;
-        DescriptorPool &pool;
+        DescriptorPool *pool = nullptr;
+        DescriptorAllocator *allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
 };
\ No newline at end of file
@@ -45,7 +45,11 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-Device::Device(Window &window) : window{window} {
+Device::Device(Window &window) : window{window}, headless{window.isHeadless()} {
+  if (headless) {
+    // software implementations without WSI are acceptable
+    deviceExtensions.clear();
+  }
   createInstance();
   setupDebugMessenger();
   createSurface();
@@ -62,7 +66,9 @@ Device::~Device() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -77,7 +83,19 @@ void Device::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // 1.0 loaders lack vkEnumerateInstanceVersion, so it is looked up rather than linked
+  auto enumerateInstanceVersion =
+      (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+  if (enumerateInstanceVersion != nullptr) {
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    enumerateInstanceVersion(&loaderVersion);
+    if (loaderVersion >= VK_API_VERSION_1_3) {
+      instanceApiVersion = VK_API_VERSION_1_3;
+    } else if (loaderVersion >= VK_API_VERSION_1_2) {
+      instanceApiVersion = VK_API_VERSION_1_2;
+    }
+  }
+  appInfo.apiVersion = instanceApiVersion;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -129,6 +147,10 @@ void Device::pickPhysicalDevice() {
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
   std::cout << "physical device: " << properties.deviceName << std::endl;
+
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  memoryTracker_.setMemoryProperties(memoryProperties);
 }
 
 void Device::createLogicalDevice() {
@@ -147,8 +169,14 @@ void Device::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // optional, only the gpu profiler uses it
+  deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+  pipelineStatisticsEnabled = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -157,6 +185,90 @@ void Device::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
+
+  VkPhysicalDeviceVulkan13Features features13 = {};
+  features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+  if (instanceApiVersion >= VK_API_VERSION_1_3 && properties.apiVersion >= VK_API_VERSION_1_3) {
+    auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(
+        instance,
+        "vkGetPhysicalDeviceFeatures2");
+    VkPhysicalDeviceFeatures2 supported = {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &features13;
+    getFeatures2(physicalDevice, &supported);
+
+    if (features13.dynamicRendering) {
+      // only request what is used, the query filled in every 1.3 feature
+      features13 = {};
+      features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+      features13.dynamicRendering = VK_TRUE;
+      createInfo.pNext = &features13;
+      dynamicRenderingEnabled = true;
+    }
+  }
+
+  // descriptor indexing is optional, bindless descriptors need it. Core from Vulkan 1.2
+  VkPhysicalDeviceVulkan12Features features12 = {};
+  features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  if (instanceApiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2) {
+    auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(
+        instance,
+        "vkGetPhysicalDeviceFeatures2");
+    VkPhysicalDeviceFeatures2 supported = {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &features12;
+    getFeatures2(physicalDevice, &supported);
+
+    if (features12.runtimeDescriptorArray && features12.descriptorBindingPartiallyBound &&
+        features12.descriptorBindingUpdateUnusedWhilePending &&
+        features12.descriptorBindingSampledImageUpdateAfterBind &&
+        features12.descriptorBindingStorageBufferUpdateAfterBind) {
+      VkBool32 nonUniformImages = features12.shaderSampledImageArrayNonUniformIndexing;
+      features12 = {};
+      features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      features12.runtimeDescriptorArray = VK_TRUE;
+      features12.descriptorBindingPartiallyBound = VK_TRUE;
+      features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+      features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+      features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+      features12.shaderSampledImageArrayNonUniformIndexing = nonUniformImages;
+      features12.pNext = const_cast<void *>(createInfo.pNext);
+      createInfo.pNext = &features12;
+      descriptorIndexingEnabled = true;
+
+      auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(
+          instance,
+          "vkGetPhysicalDeviceProperties2");
+      descriptorIndexingProperties_.sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+      VkPhysicalDeviceProperties2 properties2 = {};
+      properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+      properties2.pNext = &descriptorIndexingProperties_;
+      getProperties2(physicalDevice, &properties2);
+    }
+  }
+
+  // heap budgets are optional, memory properties 2 is core from Vulkan 1.1
+  if (instanceApiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        physicalDevice,
+        nullptr,
+        &extensionCount,
+        availableExtensions.data());
+    for (const auto &extension : availableExtensions) {
+      if (std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(
+            instance,
+            "vkGetPhysicalDeviceMemoryProperties2");
+        memoryBudgetEnabled = getMemoryProperties2 != nullptr;
+        break;
+      }
+    }
+  }
   createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
   createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -175,6 +287,12 @@ void Device::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+  if (dynamicRenderingEnabled) {
+    cmdBeginRendering = (PFN_vkCmdBeginRendering)vkGetDeviceProcAddr(device_, "vkCmdBeginRendering");
+    cmdEndRendering = (PFN_vkCmdEndRendering)vkGetDeviceProcAddr(device_, "vkCmdEndRendering");
+    dynamicRenderingEnabled = cmdBeginRendering != nullptr && cmdEndRendering != nullptr;
+  }
 }
 
 void Device::createCommandPool() {
@@ -191,15 +309,21 @@ void Device::createCommandPool() {
   }
 }
 
-void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+void Device::createSurface() {
+  if (headless) {
+    surface_ = VK_NULL_HANDLE;
+    return;
+  }
+  window.createWindowSurface(instance, &surface_);
+}
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = headless;
+  if (extensionsSupported && !headless) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -259,11 +383,13 @@ bool Device::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> Device::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (!headless) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -330,8 +456,11 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    // nothing is presented headless, the graphics queue stands in for the present queue
+    VkBool32 presentSupport = headless && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+    if (!headless) {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
@@ -401,12 +530,56 @@ uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
   throw std::runtime_error("failed to find suitable memory type!");
 }
 
+uint32_t Device::findMemoryType(
+    uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  // the type with the most preferred bits wins, ties go to the lower index
+  uint32_t best = UINT32_MAX;
+  int bestScore = -1;
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    VkMemoryPropertyFlags flags = memProperties.memoryTypes[i].propertyFlags;
+    if (!(typeFilter & (1 << i)) || (flags & properties) != properties) continue;
+    int score = 0;
+    for (VkMemoryPropertyFlags bits = flags & preferred; bits != 0; bits &= bits - 1) {
+      score++;
+    }
+    if (score > bestScore) {
+      best = i;
+      bestScore = score;
+    }
+  }
+  if (best == UINT32_MAX) {
+    throw std::runtime_error("failed to find suitable memory type!");
+  }
+  return best;
+}
+
+VkMemoryPropertyFlags Device::getMemoryTypeProperties(uint32_t typeIndex) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  return memProperties.memoryTypes[typeIndex].propertyFlags;
+}
+
+bool Device::supportsLazilyAllocatedMemory() {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void Device::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    VkMemoryPropertyFlags preferredProperties,
+    VkMemoryPropertyFlags *allocatedProperties) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -423,11 +596,16 @@ void Device::createBuffer(
   VkMemoryAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
   allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  allocInfo.memoryTypeIndex =
+      findMemoryType(memRequirements.memoryTypeBits, properties, preferredProperties);
 
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate vertex buffer memory!");
   }
+  if (allocatedProperties != nullptr) {
+    *allocatedProperties = getMemoryTypeProperties(allocInfo.memoryTypeIndex);
+  }
+  memoryTracker_.track(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, bufferMemoryCategory(usage));
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
@@ -473,6 +651,16 @@ void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
+  // covers copies back into host visible memory, e.g. Model::readBack
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
   endSingleTimeCommands(commandBuffer);
 }
 
@@ -503,6 +691,43 @@ void Device::copyBufferToImage(
   endSingleTimeCommands(commandBuffer);
 }
 
+void Device::copyImageToBuffer(VkImage image, VkBuffer buffer, uint32_t width, uint32_t height) {
+  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+
+  vkCmdCopyImageToBuffer(
+      commandBuffer,
+      image,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      buffer,
+      1,
+      &region);
+
+  // make the copy visible to host reads once the queue is idle
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+  endSingleTimeCommands(commandBuffer);
+}
+
 void Device::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
@@ -523,8 +748,28 @@ void Device::createImageWithInfo(
   if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate image memory!");
   }
+  memoryTracker_.track(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, imageMemoryCategory(imageInfo.usage));
 
   if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
-}
\ No newline at end of file
+}
+
+void Device::freeMemory(VkDeviceMemory memory) {
+  memoryTracker_.untrack(memory);
+  vkFreeMemory(device_, memory, nullptr);
+}
+
+void Device::pollMemoryBudget() {
+  if (!memoryBudgetEnabled) {
+    memoryTracker_.updateBudgets(nullptr, nullptr);
+    return;
+  }
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+  memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  memoryProperties.pNext = &budgetProperties;
+  getMemoryProperties2(physicalDevice, &memoryProperties);
+  memoryTracker_.updateBudgets(budgetProperties.heapBudget, budgetProperties.heapUsage);
+}
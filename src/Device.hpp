@@ -1,5 +1,6 @@
 #pragma once
 #include "Window.hpp"
+#include "MemoryTracker.hpp"
 
 // std lib headers
 #include <string>
@@ -44,31 +45,67 @@ class Device {
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  // Among the types with every bit of properties, picks the one with the most bits of preferred
+  uint32_t findMemoryType(
+      uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred);
+  VkMemoryPropertyFlags getMemoryTypeProperties(uint32_t typeIndex);
+  bool supportsLazilyAllocatedMemory();
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // allocatedProperties, when given, receives every property of the memory type picked
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      VkMemoryPropertyFlags preferredProperties = 0,
+      VkMemoryPropertyFlags *allocatedProperties = nullptr);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+  // image must be in TRANSFER_SRC_OPTIMAL layout
+  void copyImageToBuffer(VkImage image, VkBuffer buffer, uint32_t width, uint32_t height);
 
   void createImageWithInfo(
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
       VkDeviceMemory &imageMemory);
+  // Frees memory from createBuffer / createImageWithInfo, or memory passed to the tracker
+  void freeMemory(VkDeviceMemory memory);
 
   VkPhysicalDeviceProperties properties;
 
+  // Every allocation made through the helpers above is tracked by heap and category
+  MemoryTracker &memoryTracker() { return memoryTracker_; }
+  // Refreshes heap budgets, from VK_EXT_memory_budget when the device has it. Call once a frame.
+  void pollMemoryBudget();
+  bool supportsMemoryBudget() const { return memoryBudgetEnabled; }
+
+  // No surface, swapchain extension or presentation, frames go to offscreen images
+  bool isHeadless() const { return headless; }
+
+  // Core in Vulkan 1.3, enabled whenever both the loader and the device support it
+  bool supportsDynamicRendering() const { return dynamicRenderingEnabled; }
+  PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+  PFN_vkCmdEndRendering cmdEndRendering = nullptr;
+
+  // Pipeline statistics query pools, enabled when the device has the feature
+  bool supportsPipelineStatistics() const { return pipelineStatisticsEnabled; }
+
+  // Partially bound, update after bind descriptor arrays, core in Vulkan 1.2
+  bool supportsDescriptorIndexing() const { return descriptorIndexingEnabled; }
+  // Limits for update after bind sets, only filled in when descriptor indexing is supported
+  const VkPhysicalDeviceDescriptorIndexingProperties &descriptorIndexingProperties() const {
+    return descriptorIndexingProperties_;
+  }
+
  private:
   void createInstance();
   void setupDebugMessenger();
@@ -94,10 +131,20 @@ class Device {
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
 
+  bool headless;
+  uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+  bool dynamicRenderingEnabled = false;
+  bool pipelineStatisticsEnabled = false;
+  bool memoryBudgetEnabled = false;
+  bool descriptorIndexingEnabled = false;
+  VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties_ = {};
+  PFN_vkGetPhysicalDeviceMemoryProperties2 getMemoryProperties2 = nullptr;
+  MemoryTracker memoryTracker_;
+
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "FrameCapture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#define CAPTURE_MAGIC 0x43465256u // "VRFC"
+#define CAPTURE_VERSION 1u
+
+namespace {
+    template<typename T>
+    void writeValue(std::ostream& out, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written raw");
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void readValue(std::istream& in, T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read raw");
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("Frame capture is truncated");
+        }
+    }
+
+    template<typename T>
+    void writeVector(std::ostream& out, const std::vector<T>& values) {
+        writeValue(out, static_cast<uint64_t>(values.size()));
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template<typename T>
+    void readVector(std::istream& in, std::vector<T>& values) {
+        uint64_t count = 0;
+        readValue(in, count);
+        values.resize(count);
+        if (!in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T))) {
+            throw std::runtime_error("Frame capture is truncated");
+        }
+    }
+
+    const char* opName(DrawStream::Op op) {
+        switch (op) {
+            case DrawStream::Op::BindPipeline: return "bind pipeline";
+            case DrawStream::Op::BindDescriptorSets: return "bind descriptor sets";
+            case DrawStream::Op::PushConstants: return "push constants";
+            case DrawStream::Op::BindModel: return "bind model";
+            case DrawStream::Op::Draw: return "draw";
+            case DrawStream::Op::DrawIndexed: return "draw indexed";
+            case DrawStream::Op::Dispatch: return "dispatch";
+            case DrawStream::Op::BufferContents: return "buffer contents";
+        }
+        return "unknown";
+    }
+}
+
+void DrawStream::add(Op op, uint32_t a, uint32_t b, uint32_t c, const void* data, size_t size) {
+    Command command{op, {a, b, c}, static_cast<uint32_t>(payload.size()), static_cast<uint32_t>(size)};
+    if (size > 0) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        payload.insert(payload.end(), bytes, bytes + size);
+    }
+    commands.push_back(command);
+}
+
+void DrawStream::bindPipeline(const char* name) {
+    add(Op::BindPipeline, 0, 0, 0, name, std::strlen(name));
+}
+
+void DrawStream::bindDescriptorSets(uint32_t firstSet, uint32_t count) {
+    add(Op::BindDescriptorSets, firstSet, count, 0);
+}
+
+void DrawStream::pushConstants(uint32_t offset, uint32_t size, const void* data) {
+    add(Op::PushConstants, offset, size, 0, data, size);
+}
+
+void DrawStream::bindModel(const Model* model) {
+    auto found = modelIndices.find(model);
+    uint32_t index;
+    if (found != modelIndices.end()) {
+        index = found->second;
+    } else {
+        index = static_cast<uint32_t>(models.size());
+        models.push_back(model);
+        modelIndices.emplace(model, index);
+    }
+    add(Op::BindModel, index, 0, 0);
+}
+
+void DrawStream::drawModel(const Model* model) {
+    if (model->isIndexed()) {
+        drawIndexed(model->getIndexCount(), 1);
+    } else {
+        draw(model->getVertexCount(), 1);
+    }
+}
+
+void DrawStream::draw(uint32_t vertexCount, uint32_t instanceCount) {
+    add(Op::Draw, vertexCount, instanceCount, 0);
+}
+
+void DrawStream::drawIndexed(uint32_t indexCount, uint32_t instanceCount) {
+    add(Op::DrawIndexed, indexCount, instanceCount, 0);
+}
+
+void DrawStream::dispatch(uint32_t x, uint32_t y, uint32_t z) {
+    add(Op::Dispatch, x, y, z);
+}
+
+void DrawStream::bufferContents(const char* name, const void* data, size_t size) {
+    // the name leads the payload, args[0] is its length
+    uint32_t nameLength = static_cast<uint32_t>(std::strlen(name));
+    std::vector<uint8_t> bytes(name, name + nameLength);
+    auto contents = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), contents, contents + size);
+    add(Op::BufferContents, nameLength, 0, 0, bytes.data(), bytes.size());
+}
+
+uint32_t DrawStream::modelIndex(const Model* model) const {
+    auto found = modelIndices.find(model);
+    return found != modelIndices.end() ? found->second : UINT32_MAX;
+}
+
+// FNV-1a over the commands and their payloads
+uint64_t DrawStream::hash() const {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    for (const Command& command : commands) {
+        mix(&command.op, sizeof(command.op));
+        mix(command.args, sizeof(command.args));
+        mix(payload.data() + command.payloadOffset, command.payloadSize);
+    }
+    return hash;
+}
+
+bool DrawStream::sameCommand(const DrawStream& other, size_t index) const {
+    const Command& a = commands[index];
+    const Command& b = other.commands[index];
+    return a.op == b.op &&
+        std::memcmp(a.args, b.args, sizeof(a.args)) == 0 &&
+        a.payloadSize == b.payloadSize &&
+        std::memcmp(payload.data() + a.payloadOffset, other.payload.data() + b.payloadOffset, a.payloadSize) == 0;
+}
+
+size_t DrawStream::firstDifference(const DrawStream& other) const {
+    size_t common = std::min(commands.size(), other.commands.size());
+    for (size_t i = 0; i < common; i++) {
+        if (!sameCommand(other, i)) return i;
+    }
+    return commands.size() == other.commands.size() ? SIZE_MAX : common;
+}
+
+std::string DrawStream::describe(size_t index) const {
+    if (index >= commands.size()) {
+        return "end of stream";
+    }
+    const Command& command = commands[index];
+    const char* bytes = reinterpret_cast<const char*>(payload.data() + command.payloadOffset);
+    std::ostringstream text;
+    text << opName(command.op);
+    switch (command.op) {
+        case Op::BindPipeline:
+            text << " " << std::string(bytes, command.payloadSize);
+            break;
+        case Op::BufferContents:
+            text << " " << std::string(bytes, command.args[0]) << ", " << command.payloadSize - command.args[0] << " bytes";
+            break;
+        case Op::PushConstants:
+            text << " offset " << command.args[0] << ", " << command.args[1] << " bytes";
+            break;
+        case Op::BindModel:
+            text << " " << command.args[0];
+            break;
+        default:
+            text << " " << command.args[0] << " " << command.args[1] << " " << command.args[2];
+            break;
+    }
+    return text.str();
+}
+
+void DrawStream::write(std::ostream& out) const {
+    writeVector(out, commands);
+    writeVector(out, payload);
+}
+
+DrawStream DrawStream::read(std::istream& in) {
+    DrawStream stream{};
+    readVector(in, stream.commands);
+    readVector(in, stream.payload);
+    for (const Command& command : stream.commands) {
+        if (static_cast<uint64_t>(command.payloadOffset) + command.payloadSize > stream.payload.size()) {
+            throw std::runtime_error("Frame capture has a corrupt draw stream");
+        }
+    }
+    return stream;
+}
+
+SceneState FrameCapture::scene(const std::vector<std::unique_ptr<Model>>& replayModels) const {
+    SceneState state{};
+    for (size_t i = 0; i < objects.size(); i++) {
+        const Object& object = objects[i];
+        state.objects.push_back({static_cast<Entity>(i), replayModels[object.model].get(), object.modelMatrix, object.normalMatrix});
+    }
+    state.lights = lights;
+    return state;
+}
+
+void FrameCapture::save(const std::string& path) const {
+    std::ofstream out{path, std::ios::binary};
+    if (!out) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+    writeValue(out, CAPTURE_MAGIC);
+    writeValue(out, CAPTURE_VERSION);
+    writeValue(out, renderPath);
+    writeValue(out, extent);
+    writeValue(out, frameTime);
+    writeValue(out, useSpec);
+    writeValue(out, viewerTranslation);
+    writeValue(out, viewerRotation);
+    writeVector(out, objects);
+    writeVector(out, lights);
+    writeValue(out, static_cast<uint64_t>(models.size()));
+    for (const Model::Builder& model : models) {
+        writeVector(out, model.vertices);
+        writeVector(out, model.indices);
+    }
+    stream.write(out);
+    if (!out) {
+        throw std::runtime_error("Failed to write frame capture " + path);
+    }
+}
+
+FrameCapture FrameCapture::load(const std::string& path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        throw std::runtime_error("Failed to open frame capture " + path);
+    }
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    readValue(in, magic);
+    readValue(in, version);
+    if (magic != CAPTURE_MAGIC || version != CAPTURE_VERSION) {
+        throw std::runtime_error(path + " is not a frame capture of this version");
+    }
+
+    FrameCapture capture{};
+    readValue(in, capture.renderPath);
+    readValue(in, capture.extent);
+    readValue(in, capture.frameTime);
+    readValue(in, capture.useSpec);
+    readValue(in, capture.viewerTranslation);
+    readValue(in, capture.viewerRotation);
+    readVector(in, capture.objects);
+    readVector(in, capture.lights);
+    uint64_t modelCount = 0;
+    readValue(in, modelCount);
+    capture.models.resize(modelCount);
+    for (Model::Builder& model : capture.models) {
+        readVector(in, model.vertices);
+        readVector(in, model.indices);
+    }
+    capture.stream = DrawStream::read(in);
+
+    for (const Object& object : capture.objects) {
+        if (object.model >= capture.models.size()) {
+            throw std::runtime_error(path + " references a model it does not contain");
+        }
+    }
+    return capture;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Model.hpp"
+#include "SceneState.hpp"
+#include "SwapChain.hpp"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Engine level log of what the render systems issue in a frame: pipeline binds, descriptor set
+// binds, push constants, model binds, draws, dispatches and the contents of per frame buffers.
+// Handles differ between runs, so pipelines are logged by name and models by the order they
+// were first bound, which makes streams of two runs or two builds directly comparable.
+class DrawStream {
+    public:
+        enum class Op : uint32_t {
+            BindPipeline,
+            BindDescriptorSets,
+            PushConstants,
+            BindModel,
+            Draw,
+            DrawIndexed,
+            Dispatch,
+            BufferContents
+        };
+
+        void bindPipeline(const char* name);
+        void bindDescriptorSets(uint32_t firstSet, uint32_t count);
+        void pushConstants(uint32_t offset, uint32_t size, const void* data);
+        void bindModel(const Model* model);
+        // the draw Model::draw issues for the bound model
+        void drawModel(const Model* model);
+        void draw(uint32_t vertexCount, uint32_t instanceCount);
+        void drawIndexed(uint32_t indexCount, uint32_t instanceCount);
+        void dispatch(uint32_t x, uint32_t y, uint32_t z);
+        void bufferContents(const char* name, const void* data, size_t size);
+
+        // models in first bind order, the indices BindModel refers to
+        const std::vector<const Model*>& getModels() const { return models; }
+        // UINT32_MAX for models that were never bound
+        uint32_t modelIndex(const Model* model) const;
+
+        size_t size() const { return commands.size(); }
+        uint64_t hash() const;
+        // first command that differs, or SIZE_MAX when both streams are identical
+        size_t firstDifference(const DrawStream& other) const;
+        std::string describe(size_t command) const;
+
+        void write(std::ostream& out) const;
+        static DrawStream read(std::istream& in);
+
+    private:
+        struct Command {
+            Op op;
+            uint32_t args[3];
+            // name or raw bytes in payload
+            uint32_t payloadOffset;
+            uint32_t payloadSize;
+        };
+
+        void add(Op op, uint32_t a, uint32_t b, uint32_t c, const void* data = nullptr, size_t size = 0);
+        bool sameCommand(const DrawStream& other, size_t command) const;
+
+        std::vector<Command> commands;
+        std::vector<uint8_t> payload;
+        std::vector<const Model*> models;
+        std::unordered_map<const Model*, uint32_t> modelIndices;
+};
+
+// Everything needed to render a captured frame again without the app's scene, simulation or
+// input: the scene state the systems draw from, the camera, the meshes, and the stream the
+// frame produced to check a replay against.
+struct FrameCapture {
+    struct Object {
+        uint32_t model; // index into models, matches the stream's BindModel indices
+        glm::mat4 modelMatrix;
+        glm::mat3 normalMatrix;
+    };
+
+    RenderPath renderPath{RenderPath::Forward};
+    VkExtent2D extent{};
+    float frameTime{0.f};
+    int useSpec{1};
+    glm::vec3 viewerTranslation{0.f};
+    glm::vec3 viewerRotation{0.f};
+
+    std::vector<Object> objects;
+    std::vector<RenderLight> lights;
+    std::vector<Model::Builder> models;
+    DrawStream stream;
+
+    // Scene state drawing the given models, which must have been created from models in order
+    SceneState scene(const std::vector<std::unique_ptr<Model>>& replayModels) const;
+
+    void save(const std::string& path) const;
+    static FrameCapture load(const std::string& path);
+};
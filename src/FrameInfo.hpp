@@ -1,15 +1,33 @@
 #pragma once
 
 #include "Camera.hpp"
-#include "Object.hpp"
+#include "SceneState.hpp"
 
 #include <vulkan/vulkan.h>
 
-#define MAX_LIGHTS 10
+class GpuProfiler;
+class DrawStream;
+
+// Froxel grid used for clustered shading, must match cluster_lights.comp and simple_shader.frag
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+// Lights past this many in one cluster are dropped from it and counted in
+// ClusterGrid::overflowCount, which LightClusterSystem reports. Raise it for scenes that
+// pack more lights into a froxel, each cluster reserves this many indices.
+#define MAX_LIGHTS_PER_CLUSTER 128
 
 struct PointLight {
-    glm::vec4 position{};
-    glm::vec4 color{};
+    glm::vec4 position{}; // w is radius of influence
+    glm::vec4 color{}; // w is intensity
+    glm::vec4 billboard{}; // x is the radius of the drawn sprite
+};
+
+struct ClusterGrid {
+    uint32_t lightCounts[CLUSTER_COUNT]; // capped at MAX_LIGHTS_PER_CLUSTER
+    uint32_t overflowCount; // light references dropped by full clusters this frame
+    uint32_t lightIndices[CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER];
 };
 
 struct globalUbo {
@@ -17,9 +35,10 @@ struct globalUbo {
     glm::mat4 view{1.f};
     glm::mat4 inverseView{1.f};
     glm::vec4 ambientLightColor{1.f, 1.f, 1.f, .02f}; // w is intensity
-    PointLight pointLights[MAX_LIGHTS];
+    glm::vec4 clusterParams{}; // x: near, y: far, z: screen width, w: screen height
     int numLights;
     int useSpec;
+    int clusterSlices;
 };
 
 struct FrameInfo {
@@ -28,5 +47,8 @@ struct FrameInfo {
     VkCommandBuffer commandBuffer;
     Camera& camera;
     VkDescriptorSet globalDescriptorSet;
-    Object::Map& objects;
+    uint32_t globalUboOffset; // dynamic offset of the global ubo in the uniform ring
+    const SceneState& scene;
+    GpuProfiler* profiler = nullptr; // null when profiling is off
+    DrawStream* drawStream = nullptr; // set while a frame capture or replay logs what systems issue
 };
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "GpuProfiler.hpp"
+
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+
+// scopes a single frame can record, later ones are dropped
+#define PROFILER_MAX_SCOPES 64
+// weight of the newest frame in the rolling averages
+#define PROFILER_SMOOTHING 0.05f
+
+namespace {
+    // results come back in bit order, vertex before fragment
+    constexpr VkQueryPipelineStatisticFlags STATISTICS =
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    constexpr uint32_t STATISTICS_VALUES = 2;
+
+    void accumulate(float& average, float sample, bool first) {
+        average = first ? sample : average + (sample - average) * PROFILER_SMOOTHING;
+    }
+}
+
+GpuProfiler::Scope::Scope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const std::string& name, bool statistics)
+    : profiler{profiler}, commandBuffer{commandBuffer}, scope{NO_SCOPE} {
+    if (profiler) {
+        scope = profiler->beginScope(commandBuffer, name, statistics);
+    }
+}
+
+GpuProfiler::Scope::~Scope() {
+    if (profiler) {
+        profiler->endScope(commandBuffer, scope);
+    }
+}
+
+GpuProfiler::GpuProfiler(Device& device, bool pipelineStatistics)
+    : device{device}, timestampsSupported{device.properties.limits.timestampComputeAndGraphics == VK_TRUE} {
+    if (!timestampsSupported) return;
+
+    for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * PROFILER_MAX_SCOPES;
+        if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &timestampQueryPools[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool");
+        }
+
+        if (pipelineStatistics && device.supportsPipelineStatistics()) {
+            poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            poolInfo.queryCount = PROFILER_MAX_SCOPES;
+            poolInfo.pipelineStatistics = STATISTICS;
+            if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &statisticsQueryPools[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline statistics query pool");
+            }
+        }
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+        if (timestampQueryPools[i] != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(device.device(), timestampQueryPools[i], nullptr);
+        }
+        if (statisticsQueryPools[i] != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(device.device(), statisticsQueryPools[i], nullptr);
+        }
+    }
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+    assert(openScopes == 0 && "Cannot begin a profiler frame while scopes are open");
+    if (!timestampsSupported) return;
+
+    collect(frameIndex);
+
+    currentFrame = frameIndex;
+    FrameQueries& frame = frames[frameIndex];
+    frame.records.clear();
+    frame.timestampsWritten = 0;
+    frame.statisticsWritten = 0;
+    vkCmdResetQueryPool(commandBuffer, timestampQueryPools[frameIndex], 0, 2 * PROFILER_MAX_SCOPES);
+    if (statisticsQueryPools[frameIndex] != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, statisticsQueryPools[frameIndex], 0, PROFILER_MAX_SCOPES);
+    }
+
+    frameScope = beginScope(commandBuffer, "frame");
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+    endScope(commandBuffer, frameScope);
+    frameScope = NO_SCOPE;
+    assert(openScopes == 0 && "Profiler scopes left open at the end of the frame");
+    currentFrame = -1;
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name, bool statistics) {
+    if (!timestampsSupported || currentFrame < 0) return NO_SCOPE;
+    FrameQueries& frame = frames[currentFrame];
+    if (frame.records.size() >= PROFILER_MAX_SCOPES) return NO_SCOPE;
+
+    Record record{zoneFor(name), frame.timestampsWritten, NO_SCOPE};
+    frame.timestampsWritten += 2;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPools[currentFrame], record.beginQuery);
+
+    // an enclosing scope already counting keeps the statistics, queries of one type cannot nest
+    if (statistics && statisticsQueryPools[currentFrame] != VK_NULL_HANDLE && !statisticsActive) {
+        record.statisticsQuery = frame.statisticsWritten++;
+        vkCmdBeginQuery(commandBuffer, statisticsQueryPools[currentFrame], record.statisticsQuery, 0);
+        statisticsActive = true;
+    }
+
+    frame.records.push_back(record);
+    openScopes++;
+    return static_cast<uint32_t>(frame.records.size() - 1);
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    if (scope == NO_SCOPE) return;
+    assert(currentFrame >= 0 && scope < frames[currentFrame].records.size() && "Unknown profiler scope");
+    const Record& record = frames[currentFrame].records[scope];
+
+    if (record.statisticsQuery != NO_SCOPE) {
+        vkCmdEndQuery(commandBuffer, statisticsQueryPools[currentFrame], record.statisticsQuery);
+        statisticsActive = false;
+    }
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPools[currentFrame], record.beginQuery + 1);
+    openScopes--;
+}
+
+void GpuProfiler::collect(int frameIndex) {
+    FrameQueries& frame = frames[frameIndex];
+    if (frame.records.empty()) return;
+
+    // no wait flag, the frame's fence has signaled so every result is available
+    std::vector<uint64_t> timestamps(frame.timestampsWritten);
+    VkResult result = vkGetQueryPoolResults(
+        device.device(),
+        timestampQueryPools[frameIndex],
+        0,
+        frame.timestampsWritten,
+        timestamps.size() * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return;
+
+    std::vector<uint64_t> statistics(frame.statisticsWritten * STATISTICS_VALUES);
+    if (frame.statisticsWritten > 0) {
+        result = vkGetQueryPoolResults(
+            device.device(),
+            statisticsQueryPools[frameIndex],
+            0,
+            frame.statisticsWritten,
+            statistics.size() * sizeof(uint64_t),
+            statistics.data(),
+            STATISTICS_VALUES * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS) {
+            statistics.clear();
+        }
+    }
+
+    // timestampPeriod is in nanoseconds per tick
+    float period = device.properties.limits.timestampPeriod;
+    for (const Record& record : frame.records) {
+        Zone& zone = zones[record.zone];
+        uint64_t ticks = timestamps[record.beginQuery + 1] - timestamps[record.beginQuery];
+        accumulate(zone.averageMilliseconds, static_cast<float>(ticks) * period * 1e-6f, !zone.sampled);
+
+        if (record.statisticsQuery != NO_SCOPE && !statistics.empty()) {
+            const uint64_t* values = &statistics[record.statisticsQuery * STATISTICS_VALUES];
+            accumulate(zone.averageVertexInvocations, static_cast<float>(values[0]), !zone.hasStatistics);
+            accumulate(zone.averageFragmentInvocations, static_cast<float>(values[1]), !zone.hasStatistics);
+            zone.hasStatistics = true;
+        }
+        zone.sampled = true;
+    }
+}
+
+uint32_t GpuProfiler::zoneFor(const std::string& name) {
+    auto found = zoneIndices.find(name);
+    if (found != zoneIndices.end()) {
+        return found->second;
+    }
+    uint32_t index = static_cast<uint32_t>(zones.size());
+    zones.push_back({name, openScopes});
+    zoneIndices.emplace(name, index);
+    return index;
+}
+
+void GpuProfiler::print(std::ostream& out) const {
+    if (!timestampsSupported) {
+        out << "gpu profiler: timestamps are not supported on this device\n";
+        return;
+    }
+    out << "gpu profiler:\n" << std::fixed;
+    for (const Zone& zone : zones) {
+        if (!zone.sampled) continue;
+        out << std::string(2 * (zone.depth + 1), ' ') << zone.name << " "
+            << std::setprecision(3) << zone.averageMilliseconds << "ms";
+        if (zone.hasStatistics) {
+            out << std::setprecision(0) << " (" << zone.averageVertexInvocations << " vertex, "
+                << zone.averageFragmentInvocations << " fragment invocations)";
+        }
+        out << "\n";
+    }
+    out << std::defaultfloat;
+}
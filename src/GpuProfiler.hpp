@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Device.hpp"
+#include "SwapChain.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GPU time of named scopes, measured with timestamp queries from one pool per frame in flight.
+// Results are read when a frame index comes around again, after its fence has signaled, so
+// reading them never stalls. Scopes may nest, and keep a rolling average across frames.
+// Scopes can also count vertex and fragment shader invocations through pipeline statistics
+// queries, which cannot nest and must begin and end in the same subpass.
+class GpuProfiler {
+    public:
+        // Records a scope for its lifetime. A null profiler makes it a no-op, so call sites
+        // can be instrumented unconditionally.
+        class Scope {
+            public:
+                Scope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const std::string& name, bool statistics = false);
+                ~Scope();
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                GpuProfiler* profiler;
+                VkCommandBuffer commandBuffer;
+                uint32_t scope;
+        };
+
+        // pipelineStatistics is ignored when the device lacks pipelineStatisticsQuery
+        GpuProfiler(Device& device, bool pipelineStatistics = false);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        // Collects the results this frame index recorded last time, then resets its queries and
+        // opens the whole frame scope. Call outside a render pass once the frame's fence has
+        // signaled, i.e. after Renderer::beginFrame.
+        void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+        void endFrame(VkCommandBuffer commandBuffer);
+
+        // Prefer Scope. Returns NO_SCOPE when timestamps are unsupported or the frame ran out
+        // of queries, endScope ignores it.
+        uint32_t beginScope(VkCommandBuffer commandBuffer, const std::string& name, bool statistics = false);
+        void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        bool isEnabled() const { return timestampsSupported; }
+        bool hasPipelineStatistics() const { return statisticsQueryPools[0] != VK_NULL_HANDLE; }
+
+        // Rolling averages of every scope seen so far, nested scopes indented
+        void print(std::ostream& out) const;
+
+        static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+    private:
+        struct Zone {
+            std::string name;
+            uint32_t depth;
+            float averageMilliseconds{0.f};
+            float averageVertexInvocations{0.f};
+            float averageFragmentInvocations{0.f};
+            bool hasStatistics{false};
+            bool sampled{false};
+        };
+
+        // one scope recorded in a frame, the indices point into that frame's pools
+        struct Record {
+            uint32_t zone;
+            uint32_t beginQuery;
+            uint32_t statisticsQuery; // NO_SCOPE without statistics
+        };
+
+        struct FrameQueries {
+            std::vector<Record> records;
+            uint32_t timestampsWritten{0};
+            uint32_t statisticsWritten{0};
+        };
+
+        void collect(int frameIndex);
+        uint32_t zoneFor(const std::string& name);
+
+        Device& device;
+        bool timestampsSupported;
+        std::array<VkQueryPool, SwapChain::MAX_FRAMES_IN_FLIGHT> timestampQueryPools{};
+        std::array<VkQueryPool, SwapChain::MAX_FRAMES_IN_FLIGHT> statisticsQueryPools{};
+        std::array<FrameQueries, SwapChain::MAX_FRAMES_IN_FLIGHT> frames{};
+
+        int currentFrame{-1};
+        uint32_t frameScope{NO_SCOPE};
+        uint32_t openScopes{0};
+        bool statisticsActive{false};
+
+        std::vector<Zone> zones;
+        std::unordered_map<std::string, uint32_t> zoneIndices;
+};
@@ -0,0 +1,27 @@
+#include "ImageExport.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+void writePPM(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba) {
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* source = rgba + static_cast<size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Writes tightly packed 8 bit RGBA pixels as a binary PPM, dropping alpha. PPM needs no
+// dependencies and diffs byte for byte, which is all regression comparisons need.
+void writePPM(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
@@ -0,0 +1,170 @@
+#include "JobSystem.hpp"
+#include "CpuProfiler.hpp"
+
+#include <cassert>
+
+namespace {
+    // identifies which job system and queue the current thread works for
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local uint32_t currentQueueIndex = 0;
+}
+
+JobSystem::JobSystem(uint32_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+    for (uint32_t i = 0; i <= workerCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (uint32_t i = 1; i <= workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::shared() {
+    static JobSystem system{};
+    return system;
+}
+
+void JobSystem::run(Job job, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    push({std::move(job), counter});
+}
+
+void JobSystem::runAfter(JobCounter& dependency, Job job, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock{dependency.mutex};
+        if (dependency.pending.load(std::memory_order_acquire) > 0) {
+            dependency.continuations.push_back({std::move(job), counter});
+            return;
+        }
+    }
+    push({std::move(job), counter});
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne()) {
+            std::this_thread::yield();
+        }
+    }
+    // the finishing thread may still hold the mutex, the counter must outlive that
+    std::lock_guard<std::mutex> lock{counter.mutex};
+}
+
+uint32_t JobSystem::currentQueue() const {
+    return currentSystem == this ? currentQueueIndex : 0;
+}
+
+void JobSystem::push(Task task) {
+    // counted before it becomes visible, so a thief can never decrement below zero
+    queuedTasks.fetch_add(1);
+    WorkQueue& queue = *queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    // sleepers registers before checking queuedTasks, so either it sees this job or we see it.
+    // Taking the lock orders the notify after its predicate check.
+    if (sleepingWorkers.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+        }
+        sleepCondition.notify_one();
+    }
+}
+
+void JobSystem::schedule(std::vector<Task>& tasks) {
+    for (auto& task : tasks) {
+        push(std::move(task));
+    }
+}
+
+bool JobSystem::pop(uint32_t queueIndex, Task& task) {
+    WorkQueue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(uint32_t thiefIndex, Task& task) {
+    uint32_t count = static_cast<uint32_t>(queues.size());
+    for (uint32_t offset = 1; offset < count; offset++) {
+        WorkQueue& queue = *queues[(thiefIndex + offset) % count];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::tryRunOne() {
+    uint32_t queueIndex = currentQueue();
+    Task task;
+    if (!pop(queueIndex, task) && !steal(queueIndex, task)) {
+        return false;
+    }
+    queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    execute(task);
+    return true;
+}
+
+void JobSystem::execute(Task& task) {
+    PROFILE_SCOPE("job");
+    task.job();
+    if (task.counter) {
+        finish(*task.counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter) {
+    std::vector<Task> ready;
+    {
+        std::lock_guard<std::mutex> lock{counter.mutex};
+        if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            for (auto& continuation : counter.continuations) {
+                ready.push_back({std::move(continuation.job), continuation.counter});
+            }
+            counter.continuations.clear();
+        }
+    }
+    // the counter may be destroyed from here on
+    schedule(ready);
+}
+
+void JobSystem::workerLoop(uint32_t queueIndex) {
+    currentSystem = this;
+    currentQueueIndex = queueIndex;
+    CpuProfiler::setThreadName("job worker");
+    while (true) {
+        if (tryRunOne()) continue;
+
+        std::unique_lock<std::mutex> lock{sleepMutex};
+        sleepingWorkers.fetch_add(1);
+        sleepCondition.wait(lock, [this]() {
+            return stopping.load() || queuedTasks.load() > 0;
+        });
+        sleepingWorkers.fetch_sub(1);
+        if (stopping && queuedTasks.load() == 0) return;
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of unfinished jobs scheduled against it. Waiting on a counter, or queueing work
+// behind it with runAfter, is how dependencies between jobs are expressed.
+class JobCounter {
+    public:
+        JobCounter() = default;
+
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+
+        struct Continuation {
+            std::function<void()> job;
+            JobCounter* counter;
+        };
+
+        std::atomic<uint32_t> pending{0};
+        // guards the transition to zero, so continuations are neither lost nor run twice
+        std::mutex mutex;
+        std::vector<Continuation> continuations;
+};
+
+// Worker threads with one deque each. Owners push and pop at the back for locality, idle
+// workers steal the oldest job from the front of another deque. Threads that wait on a
+// counter run queued jobs in the meantime, so waiting inside a job never deadlocks.
+class JobSystem {
+    public:
+        using Job = std::function<void()>;
+
+        // 0 picks one worker less than the hardware threads, the submitting thread helps out
+        explicit JobSystem(uint32_t workerCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void run(Job job, JobCounter* counter = nullptr);
+        // Queues job once dependency reaches zero, counter covers the deferred job as well
+        void runAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+        // Runs queued jobs on the calling thread until counter reaches zero. Once this returns
+        // the counter is no longer referenced by the job system and may be destroyed.
+        void wait(JobCounter& counter);
+
+        // Splits [0, count) into ranges of at least minPerJob and calls func(begin, end) for
+        // each, returning once all ranges are done. Small workloads stay on the caller.
+        template<typename Func>
+        void parallelFor(size_t count, size_t minPerJob, Func func);
+
+        uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+        // Process wide instance used by engine systems
+        static JobSystem& shared();
+
+    private:
+        struct Task {
+            Job job;
+            JobCounter* counter;
+        };
+
+        // deque guarded by a mutex, contention is limited to the rare steal
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void push(Task task);
+        void schedule(std::vector<Task>& tasks);
+        bool tryRunOne();
+        bool pop(uint32_t queueIndex, Task& task);
+        bool steal(uint32_t thiefIndex, Task& task);
+        void execute(Task& task);
+        void finish(JobCounter& counter);
+        void workerLoop(uint32_t queueIndex);
+        uint32_t currentQueue() const;
+
+        // queue 0 collects jobs submitted from threads that are not workers
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<size_t> queuedTasks{0};
+        std::atomic<bool> stopping{false};
+        std::atomic<uint32_t> sleepingWorkers{0};
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+};
+
+// ranges handed out per worker, more than one so stealing can even out uneven ranges
+#define JOB_RANGES_PER_THREAD 4
+
+template<typename Func>
+void JobSystem::parallelFor(size_t count, size_t minPerJob, Func func) {
+    size_t maxRanges = (workers.size() + 1) * JOB_RANGES_PER_THREAD;
+    size_t ranges = std::min(maxRanges, count / std::max<size_t>(1, minPerJob));
+    if (ranges <= 1) {
+        func(size_t(0), count);
+        return;
+    }
+
+    size_t chunk = (count + ranges - 1) / ranges;
+    JobCounter counter;
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        size_t end = std::min(begin + chunk, count);
+        run([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+    // the caller takes the first range instead of idling
+    func(size_t(0), std::min(chunk, count));
+    wait(counter);
+}
@@ -2,7 +2,7 @@
 #include "FrameInfo.hpp"
 #include <iostream>
 
-void KeyboardMoveController::moveInPlaneXZ(GLFWwindow* window, float dt, Object& object) {
+void KeyboardMoveController::moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform) {
     glm::vec3 rotate{0};
     if(glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
     if(glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.f;
@@ -10,13 +10,13 @@ void KeyboardMoveController::moveInPlaneXZ(GLFWwindow* window, float dt, Object&
     if(glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
 
     if(glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-        object.transform.rotation += turnSpeed * dt * glm::normalize(rotate);
+        transform.rotation += turnSpeed * dt * glm::normalize(rotate);
     }
 
-    object.transform.rotation.x = glm::clamp(object.transform.rotation.x, -1.5f, 1.5f);
-    object.transform.rotation.y = glm::mod(object.transform.rotation.y, glm::two_pi<float>());
+    transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+    transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-    float yaw = object.transform.rotation.y;
+    float yaw = transform.rotation.y;
     const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
     const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
     const glm::vec3 upDir{0.f, -1.f, 0.f};
@@ -30,17 +30,17 @@ void KeyboardMoveController::moveInPlaneXZ(GLFWwindow* window, float dt, Object&
     if(glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
 
     if(glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-        object.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+        transform.translation += moveSpeed * dt * glm::normalize(moveDir);
     }
 }
 
-void KeyboardMoveController::settings(GLFWwindow* window, float dt, Object& object) {
+void KeyboardMoveController::settings(GLFWwindow* window, float dt, int& useSpec) {
 
     if(glfwGetKey(window, keys.specHighlight) == GLFW_PRESS && settingsJustPressed == 0) {
-        if(object.useSpec == 1) {
-            object.useSpec = 0;
+        if(useSpec == 1) {
+            useSpec = 0;
         } else {
-            object.useSpec = 1;
+            useSpec = 1;
         }
         settingsJustPressed = 1;
     }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Object.hpp"
+#include "Components.hpp"
 #include "Window.hpp"
 
 class KeyboardMoveController {
@@ -19,8 +19,8 @@ class KeyboardMoveController {
             int specHighlight = GLFW_KEY_P;
         };
 
-        void moveInPlaneXZ(GLFWwindow* window, float dt, Object& object);
-        void settings(GLFWwindow* window, float dt, Object& object);
+        void moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform);
+        void settings(GLFWwindow* window, float dt, int& useSpec);
 
         KeyMappings keys{};
         float moveSpeed{3.f};
@@ -0,0 +1,197 @@
+#include "LightBinning.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define LIGHT_BINNING_SSE
+#endif
+
+// below this many lights the cost of scheduling jobs outweighs the binning itself
+#define PARALLEL_BINNING_THRESHOLD 256
+
+LightBinner::LightBinner(uint32_t tilesX, uint32_t tilesY, uint32_t maxLightsPerTile)
+    : tilesX{tilesX}, tilesY{tilesY}, maxLightsPerTile{maxLightsPerTile} {
+    lightCounts.resize(tilesX * tilesY);
+    lightIndices.resize(tilesX * tilesY * maxLightsPerTile);
+    rowOverflow.resize(tilesY);
+}
+
+uint32_t LightBinner::getOverflowCount() const {
+    return std::accumulate(rowOverflow.begin(), rowOverflow.end(), 0u);
+}
+
+void LightBinner::bin(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, float near) {
+    size_t count = lights.size();
+    size_t padded = (count + 3) & ~size_t(3);
+    centerX.assign(padded, 0.f);
+    centerY.assign(padded, 0.f);
+    centerZ.assign(padded, -1.f);
+    radius.assign(padded, 0.f);
+
+    for (size_t i = 0; i < count; i++) {
+        glm::vec4 viewPos = view * glm::vec4(glm::vec3(lights[i].position), 1.f);
+        centerX[i] = viewPos.x;
+        centerY[i] = viewPos.y;
+        centerZ[i] = viewPos.z;
+        radius[i] = lights[i].position.w;
+    }
+
+    tileRects.resize(padded);
+    computeTileRects(projection, near);
+    tileRects.resize(count);
+
+    if (count < PARALLEL_BINNING_THRESHOLD) {
+        binRows(0, tilesY);
+        return;
+    }
+
+    // every tile row is owned by exactly one job, so no synchronization is needed on the output
+    JobSystem::shared().parallelFor(tilesY, 1, [this](size_t begin, size_t end) {
+        binRows(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+    });
+}
+
+// The sphere is bounded by the view space box [c - r, c + r], and x / z over that box is
+// extremal at its corners, so the projected corners give a conservative screen rectangle.
+void LightBinner::computeTileRects(const glm::mat4& projection, float near) {
+    const float scaleX = projection[0][0];
+    const float scaleY = projection[1][1];
+    const float halfTilesX = 0.5f * tilesX;
+    const float halfTilesY = 0.5f * tilesY;
+    // folded the same way as the SSE path so both round identically
+    const float tileScaleX = scaleX * halfTilesX;
+    const float tileScaleY = scaleY * halfTilesY;
+    size_t i = 0;
+
+#ifdef LIGHT_BINNING_SSE
+    const __m128 vNear = _mm_set1_ps(near);
+    const __m128 vScaleX = _mm_set1_ps(tileScaleX);
+    const __m128 vScaleY = _mm_set1_ps(tileScaleY);
+    const __m128 vOffsetX = _mm_set1_ps(halfTilesX);
+    const __m128 vOffsetY = _mm_set1_ps(halfTilesY);
+
+    for (; simdEnabled && i + 4 <= centerX.size(); i += 4) {
+        __m128 cx = _mm_loadu_ps(&centerX[i]);
+        __m128 cy = _mm_loadu_ps(&centerY[i]);
+        __m128 cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 r = _mm_loadu_ps(&radius[i]);
+
+        __m128 zNear = _mm_sub_ps(cz, r);
+        __m128 zFar = _mm_add_ps(cz, r);
+        __m128 behind = _mm_cmple_ps(zFar, vNear);
+        __m128 crossesNear = _mm_cmplt_ps(zNear, vNear);
+        __m128 invNear = _mm_div_ps(_mm_set1_ps(1.f), _mm_max_ps(zNear, vNear));
+        __m128 invFar = _mm_div_ps(_mm_set1_ps(1.f), _mm_max_ps(zFar, vNear));
+
+        __m128 x0 = _mm_sub_ps(cx, r), x1 = _mm_add_ps(cx, r);
+        __m128 y0 = _mm_sub_ps(cy, r), y1 = _mm_add_ps(cy, r);
+        __m128 minX = _mm_min_ps(_mm_mul_ps(x0, invNear), _mm_mul_ps(x0, invFar));
+        __m128 maxX = _mm_max_ps(_mm_mul_ps(x1, invNear), _mm_mul_ps(x1, invFar));
+        __m128 minY = _mm_min_ps(_mm_mul_ps(y0, invNear), _mm_mul_ps(y0, invFar));
+        __m128 maxY = _mm_max_ps(_mm_mul_ps(y1, invNear), _mm_mul_ps(y1, invFar));
+
+        // ndc -> tile coordinates
+        minX = _mm_add_ps(_mm_mul_ps(minX, vScaleX), vOffsetX);
+        maxX = _mm_add_ps(_mm_mul_ps(maxX, vScaleX), vOffsetX);
+        minY = _mm_add_ps(_mm_mul_ps(minY, vScaleY), vOffsetY);
+        maxY = _mm_add_ps(_mm_mul_ps(maxY, vScaleY), vOffsetY);
+
+        // off screen tests are done in float since truncation rounds negative tiles towards zero
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 hiX = _mm_set1_ps(static_cast<float>(tilesX));
+        const __m128 hiY = _mm_set1_ps(static_cast<float>(tilesY));
+        __m128 offscreen = _mm_or_ps(
+            _mm_or_ps(_mm_cmplt_ps(maxX, zero), _mm_cmpge_ps(minX, hiX)),
+            _mm_or_ps(_mm_cmplt_ps(maxY, zero), _mm_cmpge_ps(minY, hiY)));
+
+        // clamp before converting so the int conversion can't overflow on huge projections
+        __m128i tMinX = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(minX, zero), hiX));
+        __m128i tMaxX = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(maxX, zero), hiX));
+        __m128i tMinY = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(minY, zero), hiY));
+        __m128i tMaxY = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(maxY, zero), hiY));
+
+        alignas(16) int32_t rect[4][4];
+        alignas(16) int32_t culled[4];
+        alignas(16) int32_t fullscreen[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(rect[0]), tMinX);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rect[1]), tMinY);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rect[2]), tMaxX);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rect[3]), tMaxY);
+        _mm_store_si128(reinterpret_cast<__m128i*>(culled), _mm_castps_si128(_mm_or_ps(behind, _mm_andnot_ps(crossesNear, offscreen))));
+        _mm_store_si128(reinterpret_cast<__m128i*>(fullscreen), _mm_castps_si128(crossesNear));
+
+        for (int lane = 0; lane < 4; lane++) {
+            TileRect& out = tileRects[i + lane];
+            if (culled[lane]) {
+                out = {0, 0, -1, -1};
+            } else if (fullscreen[lane]) {
+                out = {0, 0, static_cast<int32_t>(tilesX) - 1, static_cast<int32_t>(tilesY) - 1};
+            } else {
+                out.minX = rect[0][lane];
+                out.minY = rect[1][lane];
+                out.maxX = std::min(rect[2][lane], static_cast<int32_t>(tilesX) - 1);
+                out.maxY = std::min(rect[3][lane], static_cast<int32_t>(tilesY) - 1);
+            }
+        }
+    }
+#endif
+
+    for (; i < centerX.size(); i++) {
+        float cx = centerX[i], cy = centerY[i], cz = centerZ[i], r = radius[i];
+        TileRect& out = tileRects[i];
+        if (cz + r <= near) {
+            out = {0, 0, -1, -1};
+            continue;
+        }
+        if (cz - r < near) {
+            out = {0, 0, static_cast<int32_t>(tilesX) - 1, static_cast<int32_t>(tilesY) - 1};
+            continue;
+        }
+        float invNear = 1.f / (cz - r);
+        float invFar = 1.f / (cz + r);
+        float minX = std::min((cx - r) * invNear, (cx - r) * invFar) * tileScaleX + halfTilesX;
+        float maxX = std::max((cx + r) * invNear, (cx + r) * invFar) * tileScaleX + halfTilesX;
+        float minY = std::min((cy - r) * invNear, (cy - r) * invFar) * tileScaleY + halfTilesY;
+        float maxY = std::max((cy + r) * invNear, (cy + r) * invFar) * tileScaleY + halfTilesY;
+        if (maxX < 0.f || maxY < 0.f || minX >= tilesX || minY >= tilesY) {
+            out = {0, 0, -1, -1};
+            continue;
+        }
+        out.minX = std::max(static_cast<int32_t>(minX), 0);
+        out.minY = std::max(static_cast<int32_t>(minY), 0);
+        out.maxX = std::min(static_cast<int32_t>(maxX), static_cast<int32_t>(tilesX) - 1);
+        out.maxY = std::min(static_cast<int32_t>(maxY), static_cast<int32_t>(tilesY) - 1);
+    }
+}
+
+void LightBinner::binRows(uint32_t rowBegin, uint32_t rowEnd) {
+    for (uint32_t tile = rowBegin * tilesX; tile < rowEnd * tilesX; tile++) {
+        lightCounts[tile] = 0;
+    }
+    for (uint32_t row = rowBegin; row < rowEnd; row++) {
+        rowOverflow[row] = 0;
+    }
+
+    // lights are visited in index order so every tile list comes out sorted
+    for (uint32_t light = 0; light < tileRects.size(); light++) {
+        const TileRect& rect = tileRects[light];
+        int32_t y0 = std::max(rect.minY, static_cast<int32_t>(rowBegin));
+        int32_t y1 = std::min(rect.maxY, static_cast<int32_t>(rowEnd) - 1);
+        for (int32_t y = y0; y <= y1; y++) {
+            for (int32_t x = rect.minX; x <= rect.maxX; x++) {
+                uint32_t tile = y * tilesX + x;
+                uint32_t& count = lightCounts[tile];
+                if (count < maxLightsPerTile) {
+                    lightIndices[tile * maxLightsPerTile + count] = light;
+                    count++;
+                } else {
+                    rowOverflow[y]++;
+                }
+            }
+        }
+    }
+}
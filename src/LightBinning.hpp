@@ -0,0 +1,51 @@
+#pragma once
+
+#include "FrameInfo.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Screen space light culling on the CPU. Light spheres are projected to conservative
+// tile rectangles four at a time with SSE, then tiles are filled in parallel by row.
+class LightBinner {
+    public:
+        // Inclusive tile range covered by a light, minX > maxX means culled
+        struct TileRect {
+            int32_t minX, minY, maxX, maxY;
+        };
+
+        LightBinner(uint32_t tilesX, uint32_t tilesY, uint32_t maxLightsPerTile);
+
+        void bin(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, float near);
+
+        // Layout matches ClusterGrid with a single depth slice
+        const std::vector<uint32_t>& getLightCounts() const { return lightCounts; }
+        const std::vector<uint32_t>& getLightIndices() const { return lightIndices; }
+        const std::vector<TileRect>& getTileRects() const { return tileRects; }
+        // light references dropped by tiles that already held maxLightsPerTile lights
+        uint32_t getOverflowCount() const;
+
+        // Projects every light with the scalar loop, which the SIMD path has to match exactly
+        void setSimdEnabled(bool enabled) { simdEnabled = enabled; }
+
+    private:
+        void computeTileRects(const glm::mat4& projection, float near);
+        void binRows(uint32_t rowBegin, uint32_t rowEnd);
+
+        uint32_t tilesX;
+        uint32_t tilesY;
+        uint32_t maxLightsPerTile;
+        bool simdEnabled{true};
+
+        // view space light spheres in SoA layout, padded to a multiple of 4
+        std::vector<float> centerX, centerY, centerZ, radius;
+        std::vector<TileRect> tileRects;
+        std::vector<uint32_t> lightCounts;
+        std::vector<uint32_t> lightIndices;
+        // per tile row, so rows binned in parallel never share a counter
+        std::vector<uint32_t> rowOverflow;
+};
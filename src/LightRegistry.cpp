@@ -0,0 +1,70 @@
+#include "LightRegistry.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#define INVALID_SLOT UINT32_MAX
+
+LightRegistry::id_t LightRegistry::add(const PointLight& light) {
+    id_t id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<id_t>(idToSlot.size());
+        idToSlot.push_back(INVALID_SLOT);
+    }
+
+    idToSlot[id] = static_cast<uint32_t>(lights.size());
+    slotToId.push_back(id);
+    lights.push_back(light);
+    versions.push_back(nextVersion++);
+    touched.push_back(true);
+    return id;
+}
+
+void LightRegistry::remove(id_t id) {
+    assert(contains(id) && "Cannot remove a light that is not registered");
+    uint32_t slot = idToSlot[id];
+    uint32_t last = static_cast<uint32_t>(lights.size() - 1);
+
+    // move the last light into the hole, its GPU copy at this slot is now stale
+    if (slot != last) {
+        lights[slot] = lights[last];
+        touched[slot] = touched[last];
+        slotToId[slot] = slotToId[last];
+        idToSlot[slotToId[slot]] = slot;
+        versions[slot] = nextVersion++;
+    }
+
+    lights.pop_back();
+    versions.pop_back();
+    touched.pop_back();
+    slotToId.pop_back();
+    idToSlot[id] = INVALID_SLOT;
+    freeIds.push_back(id);
+}
+
+void LightRegistry::set(id_t id, const PointLight& light) {
+    assert(contains(id) && "Cannot set a light that is not registered");
+    uint32_t slot = idToSlot[id];
+    touched[slot] = true;
+    if (std::memcmp(&lights[slot], &light, sizeof(PointLight)) != 0) {
+        lights[slot] = light;
+        versions[slot] = nextVersion++;
+    }
+}
+
+bool LightRegistry::contains(id_t id) const {
+    return id < idToSlot.size() && idToSlot[id] != INVALID_SLOT;
+}
+
+void LightRegistry::removeUntouched() {
+    // walk backwards so swap removal never moves an unvisited slot
+    for (size_t slot = lights.size(); slot-- > 0;) {
+        if (!touched[slot]) {
+            remove(slotToId[slot]);
+        }
+    }
+    touched.assign(lights.size(), false);
+}
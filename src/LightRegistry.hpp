@@ -0,0 +1,36 @@
+#pragma once
+
+#include "FrameInfo.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Densely packed point lights behind stable handles. Every slot carries a version that is
+// bumped whenever its contents change, so per frame GPU copies only upload stale slots.
+class LightRegistry {
+    public:
+        using id_t = uint32_t;
+        static constexpr id_t INVALID_ID = UINT32_MAX;
+
+        id_t add(const PointLight& light);
+        void remove(id_t id);
+        // Only bumps the slot version if the light actually changed
+        void set(id_t id, const PointLight& light);
+        bool contains(id_t id) const;
+
+        // Removes every light that was neither added nor set since the previous call
+        void removeUntouched();
+
+        const std::vector<PointLight>& getLights() const { return lights; }
+        const std::vector<uint64_t>& getVersions() const { return versions; }
+        size_t size() const { return lights.size(); }
+
+    private:
+        std::vector<PointLight> lights;
+        std::vector<uint64_t> versions;
+        std::vector<bool> touched;
+        std::vector<id_t> slotToId;
+        std::vector<uint32_t> idToSlot;
+        std::vector<id_t> freeIds;
+        uint64_t nextVersion{1};
+};
@@ -0,0 +1,160 @@
+#include "MemoryTracker.hpp"
+
+#include <cassert>
+#include <iomanip>
+
+#define MEBIBYTE (1024.0 * 1024.0)
+
+const char* memoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Geometry: return "geometry";
+        case MemoryCategory::Staging: return "staging";
+        case MemoryCategory::Uniform: return "uniform";
+        case MemoryCategory::Storage: return "storage";
+        case MemoryCategory::Depth: return "depth";
+        case MemoryCategory::Attachment: return "attachment";
+        case MemoryCategory::Texture: return "texture";
+        default: return "other";
+    }
+}
+
+MemoryCategory bufferMemoryCategory(VkBufferUsageFlags usage) {
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+        return MemoryCategory::Geometry;
+    }
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+        return MemoryCategory::Uniform;
+    }
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+        return MemoryCategory::Storage;
+    }
+    // uploads and readbacks
+    if (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+        return MemoryCategory::Staging;
+    }
+    return MemoryCategory::Other;
+}
+
+MemoryCategory imageMemoryCategory(VkImageUsageFlags usage) {
+    if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+        return MemoryCategory::Depth;
+    }
+    if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT)) {
+        return MemoryCategory::Attachment;
+    }
+    if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+        return MemoryCategory::Texture;
+    }
+    return MemoryCategory::Other;
+}
+
+void MemoryTracker::setMemoryProperties(const VkPhysicalDeviceMemoryProperties& properties) {
+    std::lock_guard<std::mutex> lock{mutex};
+    memoryProperties = properties;
+    heaps.assign(properties.memoryHeapCount, HeapBudget{});
+    overThreshold.assign(properties.memoryHeapCount, false);
+    for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+        heaps[i].size = properties.memoryHeaps[i].size;
+        heaps[i].budget = properties.memoryHeaps[i].size;
+        heaps[i].deviceLocal = (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+}
+
+void MemoryTracker::track(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, MemoryCategory category) {
+    std::lock_guard<std::mutex> lock{mutex};
+    assert(memoryTypeIndex < memoryProperties.memoryTypeCount && "Memory properties must be set before tracking");
+    uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    allocations[memory] = {size, heapIndex, category};
+    heaps[heapIndex].tracked += size;
+    categoryBytes[static_cast<size_t>(category)] += size;
+}
+
+void MemoryTracker::untrack(VkDeviceMemory memory) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto found = allocations.find(memory);
+    if (found == allocations.end()) return;
+    const Allocation& allocation = found->second;
+    heaps[allocation.heapIndex].tracked -= allocation.size;
+    categoryBytes[static_cast<size_t>(allocation.category)] -= allocation.size;
+    allocations.erase(found);
+}
+
+void MemoryTracker::updateBudgets(const VkDeviceSize* budgets, const VkDeviceSize* usages) {
+    std::vector<std::pair<uint32_t, HeapBudget>> crossed;
+    std::vector<EvictionCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (uint32_t i = 0; i < heaps.size(); i++) {
+            HeapBudget& heap = heaps[i];
+            heap.budget = budgets ? budgets[i] : heap.size;
+            heap.usage = usages ? usages[i] : heap.tracked;
+
+            bool over = heap.budget > 0 && heap.usage > static_cast<VkDeviceSize>(heap.budget * evictionThreshold);
+            if (over && !overThreshold[i]) {
+                crossed.push_back({i, heap});
+            }
+            overThreshold[i] = over;
+        }
+        if (!crossed.empty()) {
+            for (auto& entry : evictionCallbacks) {
+                callbacks.push_back(entry.second);
+            }
+        }
+    }
+    // called unlocked, evicting frees memory and comes back through untrack
+    for (auto& heap : crossed) {
+        for (auto& callback : callbacks) {
+            callback(heap.first, heap.second);
+        }
+    }
+}
+
+uint32_t MemoryTracker::addEvictionCallback(EvictionCallback callback) {
+    std::lock_guard<std::mutex> lock{mutex};
+    uint32_t id = nextCallbackId++;
+    evictionCallbacks.push_back({id, std::move(callback)});
+    return id;
+}
+
+void MemoryTracker::removeEvictionCallback(uint32_t id) {
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto it = evictionCallbacks.begin(); it != evictionCallbacks.end(); ++it) {
+        if (it->first == id) {
+            evictionCallbacks.erase(it);
+            return;
+        }
+    }
+}
+
+std::vector<HeapBudget> MemoryTracker::getHeaps() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return heaps;
+}
+
+VkDeviceSize MemoryTracker::getCategoryBytes(MemoryCategory category) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return categoryBytes[static_cast<size_t>(category)];
+}
+
+size_t MemoryTracker::getAllocationCount() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return allocations.size();
+}
+
+void MemoryTracker::printReport(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    out << std::fixed << std::setprecision(1) << "memory: " << allocations.size() << " allocations\n";
+    for (size_t i = 0; i < heaps.size(); i++) {
+        const HeapBudget& heap = heaps[i];
+        out << "  heap " << i << (heap.deviceLocal ? " (device local)" : "") << ": "
+            << heap.usage / MEBIBYTE << " of " << heap.budget / MEBIBYTE << " MiB budget, "
+            << heap.tracked / MEBIBYTE << " MiB tracked\n";
+    }
+    out << " ";
+    for (size_t i = 0; i < categoryBytes.size(); i++) {
+        if (categoryBytes[i] == 0) continue;
+        out << " " << memoryCategoryName(static_cast<MemoryCategory>(i)) << " " << categoryBytes[i] / MEBIBYTE << " MiB";
+    }
+    out << "\n" << std::defaultfloat;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+enum class MemoryCategory {
+    Geometry,   // vertex and index buffers
+    Staging,    // host visible transfer buffers
+    Uniform,
+    Storage,
+    Depth,
+    Attachment, // color, g-buffer and render graph targets
+    Texture,    // sampled images
+    Other,
+    Count
+};
+
+const char* memoryCategoryName(MemoryCategory category);
+// Categories follow from how a resource is used, so allocation sites need no extra tags
+MemoryCategory bufferMemoryCategory(VkBufferUsageFlags usage);
+MemoryCategory imageMemoryCategory(VkImageUsageFlags usage);
+
+struct HeapBudget {
+    VkDeviceSize size{0};
+    // what the driver lets this process use and what it uses, from VK_EXT_memory_budget.
+    // Without the extension budget is the heap size and usage the tracked bytes.
+    VkDeviceSize budget{0};
+    VkDeviceSize usage{0};
+    VkDeviceSize tracked{0}; // allocated through the Device helpers
+    bool deviceLocal{false};
+};
+
+// Bytes allocated per memory heap and category, and per heap budgets polled once a frame.
+// Eviction callbacks run when a heap's usage crosses the threshold fraction of its budget,
+// and again only after it has dropped back below.
+class MemoryTracker {
+    public:
+        using EvictionCallback = std::function<void(uint32_t heapIndex, const HeapBudget& heap)>;
+
+        MemoryTracker() = default;
+
+        MemoryTracker(const MemoryTracker&) = delete;
+        MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+        void setMemoryProperties(const VkPhysicalDeviceMemoryProperties& properties);
+
+        void track(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, MemoryCategory category);
+        void untrack(VkDeviceMemory memory);
+
+        // budgets and usages hold one entry per heap, null falls back to heap sizes and
+        // tracked bytes. Runs the eviction callbacks of heaps that crossed the threshold.
+        void updateBudgets(const VkDeviceSize* budgets, const VkDeviceSize* usages);
+
+        uint32_t addEvictionCallback(EvictionCallback callback);
+        void removeEvictionCallback(uint32_t id);
+        // fraction of a heap's budget at which eviction callbacks run
+        void setEvictionThreshold(float threshold) { evictionThreshold = threshold; }
+
+        std::vector<HeapBudget> getHeaps() const;
+        VkDeviceSize getCategoryBytes(MemoryCategory category) const;
+        size_t getAllocationCount() const;
+
+        void printReport(std::ostream& out) const;
+
+    private:
+        struct Allocation {
+            VkDeviceSize size;
+            uint32_t heapIndex;
+            MemoryCategory category;
+        };
+
+        // guards everything below, allocations may come from loader threads
+        mutable std::mutex mutex;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        std::vector<HeapBudget> heaps;
+        std::vector<bool> overThreshold;
+        std::array<VkDeviceSize, static_cast<size_t>(MemoryCategory::Count)> categoryBytes{};
+        std::unordered_map<VkDeviceMemory, Allocation> allocations;
+
+        float evictionThreshold{0.9f};
+        uint32_t nextCallbackId{0};
+        std::vector<std::pair<uint32_t, EvictionCallback>> evictionCallbacks;
+};
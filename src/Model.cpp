@@ -1,5 +1,6 @@
 #include "Model.hpp"
 #include "Utils.hpp"
+#include "JobSystem.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
@@ -8,6 +9,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <exception>
 #include <iostream>
 #include <unordered_map>
 
@@ -36,6 +38,33 @@ std::unique_ptr<Model> Model::createModelFromFile(Device& device, const std::str
     return std::make_unique<Model>(device, builder);
 }
 
+std::vector<std::unique_ptr<Model>> Model::createModelsFromFiles(Device& device, const std::vector<std::string>& filepaths) {
+    auto& jobs = JobSystem::shared();
+    std::vector<Builder> builders(filepaths.size());
+    std::vector<std::exception_ptr> errors(filepaths.size());
+    JobCounter parsed;
+    for (size_t i = 0; i < filepaths.size(); i++) {
+        jobs.run([&, i]() {
+            try {
+                builders[i].loadModel(filepaths[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }, &parsed);
+    }
+    jobs.wait(parsed);
+
+    std::vector<std::unique_ptr<Model>> models;
+    for (size_t i = 0; i < filepaths.size(); i++) {
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+        std::cout << "Vertex count: " << builders[i].vertices.size() << "\n";
+        models.push_back(std::make_unique<Model>(device, builders[i]));
+    }
+    return models;
+}
+
 void Model::createVertexBuffers(const std::vector<Vertex> &vertices) {
     vertexCount = static_cast<uint32_t>(vertices.size());
     assert(vertexCount >= 3 && "Vertex count must be atleast 3");
@@ -57,7 +86,7 @@ void Model::createVertexBuffers(const std::vector<Vertex> &vertices) {
         device,
         vertexSize,
         vertexCount,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
     );
 
@@ -90,13 +119,37 @@ void Model::createIndexBuffers(const std::vector<uint32_t> &indices) {
         device,
         indexSize,
         indexCount,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
     );
 
     device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
 }
 
+Model::Builder Model::readBack() const {
+    Builder builder{};
+    builder.vertices.resize(vertexCount);
+    builder.indices.resize(hasIndexBuffer ? indexCount : 0);
+
+    auto copyBack = [this](const Buffer& source, void* destination) {
+        Buffer stagingBuffer {
+            device,
+            source.getInstanceSize(),
+            source.getInstanceCount(),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+        device.copyBuffer(source.getBuffer(), stagingBuffer.getBuffer(), source.getBufferSize());
+        stagingBuffer.map();
+        std::memcpy(destination, stagingBuffer.getMappedMemory(), source.getBufferSize());
+    };
+    copyBack(*vertexBuffer, builder.vertices.data());
+    if (hasIndexBuffer) {
+        copyBack(*indexBuffer, builder.indices.data());
+    }
+    return builder;
+}
+
 void Model::draw(VkCommandBuffer commandBuffer) {
     if(hasIndexBuffer) {
         vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
@@ -39,10 +39,19 @@ class Model {
         Model& operator=(const Model &) = delete;
 
         static std::unique_ptr<Model> createModelFromFile(Device& device, const std::string& filepath);
+        // Parses the files in parallel on the job system, buffers are still created one after
+        // another since staging copies share the device's command pool and queue
+        static std::vector<std::unique_ptr<Model>> createModelsFromFiles(Device& device, const std::vector<std::string>& filepaths);
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
 
+        bool isIndexed() const { return hasIndexBuffer; }
+        uint32_t getVertexCount() const { return vertexCount; }
+        uint32_t getIndexCount() const { return indexCount; }
+        // Copies the vertices and indices back from the gpu, waits until the copy is done
+        Builder readBack() const;
+
     private:
         void createVertexBuffers(const std::vector<Vertex> &vertices);
         void createIndexBuffers(const std::vector<uint32_t> &indices);
@@ -21,11 +21,13 @@ struct PipelineConfigInfo {
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
     uint32_t subpass = 0;
+    // Used instead of renderPass when it is null, for pipelines drawn with dynamic rendering
+    std::vector<VkFormat> colorAttachmentFormats{};
+    VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
 };
 
 class Pipeline {
     private:
-        static std::vector<char> readFile(const std::string& filePath);
         void createGraphicsPipeline(
             const std::string& vertFilePath,
             const std::string& fragFilePath,
@@ -48,6 +50,22 @@ class Pipeline {
         Pipeline& operator=(const Pipeline&) = delete;
 
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        static std::vector<char> readFile(const std::string& filePath);
+
+        void bind(VkCommandBuffer commandBuffer);
+};
+
+class ComputePipeline {
+    public:
+        ComputePipeline(Device &device, const std::string& compFilePath, VkPipelineLayout pipelineLayout);
+        ~ComputePipeline();
+        ComputePipeline(const ComputePipeline&) = delete;
+        ComputePipeline& operator=(const ComputePipeline&) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        Device& device;
+        VkPipeline computePipeline;
+        VkShaderModule compShaderModule;
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "Quaternion.hpp"
+
+#include <cmath>
+
+// below this angle between inputs slerp's sin(theta) division loses precision
+#define SLERP_NLERP_THRESHOLD 0.9995f
+
+glm::quat quatFromEulerYXZ(const glm::vec3& rotation) {
+    const float cx = std::cos(rotation.x * 0.5f);
+    const float sx = std::sin(rotation.x * 0.5f);
+    const float cy = std::cos(rotation.y * 0.5f);
+    const float sy = std::sin(rotation.y * 0.5f);
+    const float cz = std::cos(rotation.z * 0.5f);
+    const float sz = std::sin(rotation.z * 0.5f);
+    // qy * qx * qz expanded
+    return glm::quat::wxyz(
+        cy * cx * cz + sy * sx * sz,
+        cy * sx * cz + sy * cx * sz,
+        sy * cx * cz - cy * sx * sz,
+        cy * cx * sz - sy * sx * cz);
+}
+
+glm::mat3 quatToMat3(const glm::quat& q) {
+    const float x2 = q.x + q.x;
+    const float y2 = q.y + q.y;
+    const float z2 = q.z + q.z;
+    const float xx = q.x * x2, xy = q.x * y2, xz = q.x * z2;
+    const float yy = q.y * y2, yz = q.y * z2, zz = q.z * z2;
+    const float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+    return glm::mat3{
+        {1.f - (yy + zz), xy + wz, xz - wy},
+        {xy - wz, 1.f - (xx + zz), yz + wx},
+        {xz + wy, yz - wx, 1.f - (xx + yy)},
+    };
+}
+
+glm::quat quatNlerp(const glm::quat& a, const glm::quat& b, float t) {
+    // q and -q are the same rotation, flip b so the blend takes the short way round
+    glm::quat target = glm::dot(a, b) < 0.f ? -b : b;
+    glm::quat result = glm::quat::wxyz(
+        a.w + (target.w - a.w) * t,
+        a.x + (target.x - a.x) * t,
+        a.y + (target.y - a.y) * t,
+        a.z + (target.z - a.z) * t);
+    return glm::normalize(result);
+}
+
+glm::quat quatSlerp(const glm::quat& a, const glm::quat& b, float t) {
+    float cosTheta = glm::dot(a, b);
+    glm::quat target = b;
+    if (cosTheta < 0.f) {
+        target = -b;
+        cosTheta = -cosTheta;
+    }
+    if (cosTheta > SLERP_NLERP_THRESHOLD) {
+        return quatNlerp(a, target, t);
+    }
+
+    const float theta = std::acos(cosTheta);
+    const float invSin = 1.f / std::sin(theta);
+    const float wa = std::sin((1.f - t) * theta) * invSin;
+    const float wb = std::sin(t * theta) * invSin;
+    return glm::quat::wxyz(
+        wa * a.w + wb * target.w,
+        wa * a.x + wb * target.x,
+        wa * a.y + wb * target.y,
+        wa * a.z + wb * target.z);
+}
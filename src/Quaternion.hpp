@@ -0,0 +1,18 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Unit quaternion equal to Ry * Rx * Rz, the Tait-Bryan order TransformComponent::rotation uses
+glm::quat quatFromEulerYXZ(const glm::vec3& rotation);
+
+// Rotation matrix of a unit quaternion, only multiplies and adds
+glm::mat3 quatToMat3(const glm::quat& q);
+
+// Normalized lerp along the shortest arc. Not constant speed, but cheap and close to slerp
+// for the small steps of per frame animation.
+glm::quat quatNlerp(const glm::quat& a, const glm::quat& b, float t);
+// Constant angular speed along the shortest arc, falls back to nlerp for nearly equal inputs
+glm::quat quatSlerp(const glm::quat& a, const glm::quat& b, float t);
@@ -0,0 +1,50 @@
+#include "RadixSort.hpp"
+
+#include <array>
+#include <cstring>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+
+uint32_t floatSortKey(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // negatives flip entirely so larger magnitudes sort first, positives just gain the sign bit
+    uint32_t mask = (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    return bits ^ mask;
+}
+
+void radixSort(const std::vector<uint32_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch) {
+    size_t count = keys.size();
+    order.resize(count);
+    scratch.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    // every histogram in one read of the keys
+    std::array<std::array<uint32_t, RADIX_BUCKETS>, RADIX_PASSES> histograms{};
+    for (uint32_t key : keys) {
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        auto& histogram = histograms[pass];
+        uint32_t shift = pass * RADIX_BITS;
+        if (count == 0 || histogram[(keys[0] >> shift) & (RADIX_BUCKETS - 1)] == count) continue;
+
+        uint32_t offset = 0;
+        for (auto& bucket : histogram) {
+            uint32_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (uint32_t index : order) {
+            scratch[histogram[(keys[index] >> shift) & (RADIX_BUCKETS - 1)]++] = index;
+        }
+        order.swap(scratch);
+    }
+}
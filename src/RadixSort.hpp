@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Maps a float onto a uint32_t whose unsigned order matches the float order
+uint32_t floatSortKey(float value);
+
+// Stable LSD radix sort over 8 bit digits, writes the indices of keys in ascending order.
+// Digits where every key agrees are skipped, so narrow key ranges only cost the histograms.
+void radixSort(const std::vector<uint32_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch);
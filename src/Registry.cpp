@@ -0,0 +1,39 @@
+#include "Registry.hpp"
+
+Entity Registry::create() {
+    uint32_t index;
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        index = static_cast<uint32_t>(generations.size());
+        assert(index <= ENTITY_INDEX_MASK && "Too many entities");
+        generations.push_back(0);
+    }
+    aliveCount++;
+    return index | (generations[index] << ENTITY_INDEX_BITS);
+}
+
+void Registry::destroy(Entity entity) {
+    assert(valid(entity) && "Cannot destroy an entity twice");
+    for (auto& pool : pools) {
+        if (pool) {
+            pool->remove(entity);
+        }
+    }
+    uint32_t index = entity & ENTITY_INDEX_MASK;
+    // generation wraps within the bits left over by the index
+    generations[index] = (generations[index] + 1) & (UINT32_MAX >> ENTITY_INDEX_BITS);
+    freeIndices.push_back(index);
+    aliveCount--;
+}
+
+bool Registry::valid(Entity entity) const {
+    uint32_t index = entity & ENTITY_INDEX_MASK;
+    return entity != NULL_ENTITY && index < generations.size() && generations[index] == (entity >> ENTITY_INDEX_BITS);
+}
+
+uint32_t Registry::nextComponentTypeId() {
+    static uint32_t nextId = 0;
+    return nextId++;
+}
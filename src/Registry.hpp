@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+using Entity = uint32_t;
+
+// Entities pack a slot index with a generation so stale handles are detected after reuse
+#define ENTITY_INDEX_BITS 24
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+#define NULL_ENTITY UINT32_MAX
+
+// Sparse set: the sparse array maps an entity index to its slot in the packed arrays.
+// Removal swaps the last element into the hole, so the packed arrays never have gaps.
+class ComponentPoolBase {
+    public:
+        virtual ~ComponentPoolBase() = default;
+        virtual void remove(Entity entity) = 0;
+
+        bool contains(Entity entity) const {
+            uint32_t index = entity & ENTITY_INDEX_MASK;
+            return index < sparse.size() && sparse[index] != UINT32_MAX && entities[sparse[index]] == entity;
+        }
+
+        size_t size() const { return entities.size(); }
+        const std::vector<Entity>& getEntities() const { return entities; }
+
+    protected:
+        std::vector<uint32_t> sparse;
+        std::vector<Entity> entities;
+};
+
+// Components of one type, packed contiguously in the same order as getEntities()
+template<typename T>
+class ComponentPool : public ComponentPoolBase {
+    public:
+        T& add(Entity entity, T component) {
+            uint32_t index = entity & ENTITY_INDEX_MASK;
+            assert(!contains(entity) && "Entity already has this component");
+            if (index >= sparse.size()) {
+                sparse.resize(index + 1, UINT32_MAX);
+            }
+            sparse[index] = static_cast<uint32_t>(entities.size());
+            entities.push_back(entity);
+            components.push_back(std::move(component));
+            return components.back();
+        }
+
+        void remove(Entity entity) override {
+            if (!contains(entity)) return;
+            uint32_t index = entity & ENTITY_INDEX_MASK;
+            uint32_t slot = sparse[index];
+            uint32_t last = static_cast<uint32_t>(entities.size() - 1);
+            if (slot != last) {
+                entities[slot] = entities[last];
+                components[slot] = std::move(components[last]);
+                sparse[entities[slot] & ENTITY_INDEX_MASK] = slot;
+            }
+            entities.pop_back();
+            components.pop_back();
+            sparse[index] = UINT32_MAX;
+        }
+
+        T& get(Entity entity) {
+            assert(contains(entity) && "Entity does not have this component");
+            return components[sparse[entity & ENTITY_INDEX_MASK]];
+        }
+
+        std::vector<T>& getComponents() { return components; }
+
+    private:
+        std::vector<T> components;
+};
+
+// Iterates entities that own every listed component, driven by the smallest pool.
+// The walk runs backwards so func may remove components from the current entity.
+template<typename... Components>
+class View {
+    public:
+        View(ComponentPool<Components>&... pools) : pools{&pools...} {}
+
+        template<typename Func>
+        void each(Func func) {
+            if constexpr (sizeof...(Components) == 1) {
+                // single pool views are a straight walk over the packed arrays
+                auto* pool = std::get<0>(pools);
+                auto& entities = pool->getEntities();
+                auto& components = pool->getComponents();
+                for (size_t i = entities.size(); i-- > 0;) {
+                    func(entities[i], components[i]);
+                }
+            } else {
+                const ComponentPoolBase* driver = std::get<0>(pools);
+                std::apply([&](auto*... pool) { ((driver = pool->size() < driver->size() ? pool : driver), ...); }, pools);
+                auto& entities = driver->getEntities();
+                for (size_t i = entities.size(); i-- > 0;) {
+                    Entity entity = entities[i];
+                    if (std::apply([&](auto*... pool) { return (pool->contains(entity) && ...); }, pools)) {
+                        func(entity, std::get<ComponentPool<Components>*>(pools)->get(entity)...);
+                    }
+                }
+            }
+        }
+
+    private:
+        std::tuple<ComponentPool<Components>*...> pools;
+};
+
+class Registry {
+    public:
+        Registry() = default;
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        Entity create();
+        void destroy(Entity entity);
+        bool valid(Entity entity) const;
+        size_t size() const { return aliveCount; }
+
+        template<typename T>
+        T& add(Entity entity, T component = T{}) {
+            assert(valid(entity) && "Cannot add a component to a destroyed entity");
+            return pool<T>().add(entity, std::move(component));
+        }
+
+        template<typename T>
+        void remove(Entity entity) { pool<T>().remove(entity); }
+
+        template<typename T>
+        bool has(Entity entity) { return pool<T>().contains(entity); }
+
+        template<typename T>
+        T& get(Entity entity) { return pool<T>().get(entity); }
+
+        template<typename... Components>
+        View<Components...> view() { return View<Components...>(pool<Components>()...); }
+
+        template<typename T>
+        ComponentPool<T>& pool() {
+            uint32_t id = componentTypeId<T>();
+            if (id >= pools.size()) {
+                pools.resize(id + 1);
+            }
+            if (!pools[id]) {
+                pools[id] = std::make_unique<ComponentPool<T>>();
+            }
+            return static_cast<ComponentPool<T>&>(*pools[id]);
+        }
+
+    private:
+        static uint32_t nextComponentTypeId();
+
+        template<typename T>
+        static uint32_t componentTypeId() {
+            static const uint32_t id = nextComponentTypeId();
+            return id;
+        }
+
+        std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> freeIndices;
+        size_t aliveCount{0};
+};
@@ -0,0 +1,481 @@
+#include "RenderGraph.hpp"
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace {
+    struct UsageInfo {
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool attachment; // layout is owned by the pass's render pass
+    };
+
+    UsageInfo usageInfo(ResourceUsage usage) {
+        switch (usage) {
+            case ResourceUsage::ColorAttachment:
+                return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+            case ResourceUsage::DepthAttachment:
+                return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+            case ResourceUsage::SampledFragment:
+                return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+            case ResourceUsage::SampledCompute:
+                return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+            case ResourceUsage::StorageReadVertex:
+                return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+            case ResourceUsage::StorageReadFragment:
+                return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+            case ResourceUsage::StorageReadCompute:
+                return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+            case ResourceUsage::StorageWriteCompute:
+                return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+            case ResourceUsage::TransferSrc:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+            case ResourceUsage::TransferDst:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false};
+            case ResourceUsage::Present:
+                return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false};
+        }
+        throw std::runtime_error("Unknown resource usage");
+    }
+
+    constexpr VkAccessFlags WRITE_ACCESS_MASK =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    // what the recorded frame has done to a resource so far
+    struct ResourceState {
+        VkPipelineStageFlags writeStages{0};
+        VkAccessFlags writeAccess{0};
+        VkPipelineStageFlags readStages{0}; // reads since the last write
+        VkPipelineStageFlags visibleStages{0}; // stages the last write has been made visible to
+        VkAccessFlags visibleAccess{0};
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+    };
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RenderResource resource, ResourceUsage usage) {
+    assert(resource < graph.resources.size() && "Unknown render graph resource");
+    graph.passes[pass].accesses.push_back({resource, usage, false, VK_IMAGE_LAYOUT_UNDEFINED});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RenderResource resource, ResourceUsage usage, VkImageLayout finalLayout) {
+    assert(resource < graph.resources.size() && "Unknown render graph resource");
+    assert((usageInfo(usage).access & WRITE_ACCESS_MASK) && "Usage does not write");
+    graph.passes[pass].accesses.push_back({resource, usage, true, finalLayout});
+    return *this;
+}
+
+RenderGraph::RenderGraph(Device& device) : device{device} {}
+
+RenderGraph::~RenderGraph() {
+    destroyCompiled();
+}
+
+RenderResource RenderGraph::importImage(const std::string& name, VkImageAspectFlags aspect) {
+    resources.push_back({name, true, true, aspect});
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+RenderResource RenderGraph::importBuffer(const std::string& name) {
+    resources.push_back({name, true, false, 0});
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+RenderResource RenderGraph::createImage(const std::string& name, const TransientImageDesc& desc) {
+    Resource resource{name, false, true, desc.aspect};
+    resource.desc = desc;
+    resources.push_back(resource);
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+void RenderGraph::setFinalUsage(RenderResource resource, ResourceUsage usage) {
+    assert(resources[resource].imported && resources[resource].image && "Final usage only applies to imported images");
+    resources[resource].hasFinalUsage = true;
+    resources[resource].finalUsage = usage;
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, ExecuteFn execute) {
+    Pass pass{};
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+    return PassBuilder{*this, static_cast<uint32_t>(passes.size() - 1)};
+}
+
+void RenderGraph::setImage(RenderResource resource, VkImage image) {
+    assert(resources[resource].imported && resources[resource].image && "Not an imported image");
+    resources[resource].importedImage = image;
+}
+
+void RenderGraph::setBuffer(RenderResource resource, VkBuffer buffer) {
+    assert(resources[resource].imported && !resources[resource].image && "Not an imported buffer");
+    resources[resource].importedBuffer = buffer;
+}
+
+VkImageView RenderGraph::getImageView(RenderResource resource, int frameIndex) const {
+    assert(!resources[resource].imported && "Views of imported images are owned by their creator");
+    return resources[resource].views[frameIndex];
+}
+
+VkImage RenderGraph::imageFor(RenderResource resource, int frameIndex) const {
+    const Resource& r = resources[resource];
+    return r.imported ? r.importedImage : r.images[frameIndex];
+}
+
+// Two transients used in disjoint ranges of passes, so compile() has to put them in one block
+void RenderGraph::checkAliasing(Device& device) {
+    RenderGraph graph{device};
+    RenderResource output = graph.importBuffer("output");
+    TransientImageDesc desc{VK_FORMAT_R8G8B8A8_UNORM, {64, 64}, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+    RenderResource first = graph.createImage("first", desc);
+    RenderResource second = graph.createImage("second", desc);
+    auto noop = [](FrameInfo&) {};
+    graph.addPass("write first", noop).write(first, ResourceUsage::TransferDst);
+    graph.addPass("copy first", noop)
+        .read(first, ResourceUsage::TransferSrc)
+        .write(output, ResourceUsage::TransferDst);
+    graph.addPass("write second", noop).write(second, ResourceUsage::TransferDst);
+    graph.addPass("copy second", noop)
+        .read(second, ResourceUsage::TransferSrc)
+        .write(output, ResourceUsage::TransferDst);
+    graph.compile();
+    if (graph.livePassCount() != 4 || graph.transientMemoryBlocks() != 1) {
+        throw std::runtime_error("Render graph did not alias transient images with disjoint lifetimes");
+    }
+}
+
+void RenderGraph::compile() {
+    destroyCompiled();
+    cullPasses();
+    computeLifetimes();
+    allocateTransients();
+    computeBarriers();
+}
+
+// A pass is live if it writes an imported resource or something a later live pass reads
+void RenderGraph::cullPasses() {
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].imported;
+    }
+
+    std::vector<bool> live(passes.size(), false);
+    for (size_t p = passes.size(); p-- > 0;) {
+        for (auto& access : passes[p].accesses) {
+            if (access.write && needed[access.resource]) {
+                live[p] = true;
+            }
+        }
+        if (!live[p]) continue;
+        for (auto& access : passes[p].accesses) {
+            if (!access.write) {
+                needed[access.resource] = true;
+            }
+        }
+    }
+
+    order.clear();
+    for (uint32_t p = 0; p < passes.size(); p++) {
+        if (live[p]) {
+            order.push_back(p);
+        }
+    }
+}
+
+void RenderGraph::computeLifetimes() {
+    for (auto& resource : resources) {
+        resource.firstUse = UINT32_MAX;
+        resource.lastUse = 0;
+    }
+    for (uint32_t position = 0; position < order.size(); position++) {
+        for (auto& access : passes[order[position]].accesses) {
+            Resource& resource = resources[access.resource];
+            resource.firstUse = std::min(resource.firstUse, position);
+            resource.lastUse = std::max(resource.lastUse, position);
+        }
+    }
+}
+
+// Greedy interval packing, largest images first. Images share a block when none of the
+// block's occupants are used in an overlapping range of passes.
+void RenderGraph::allocateTransients() {
+    std::vector<RenderResource> transients;
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        Resource& resource = resources[i];
+        if (resource.imported || resource.firstUse == UINT32_MAX) continue;
+
+        for (int frame = 0; frame < SwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = resource.desc.format;
+            imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = resource.desc.usage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if (vkCreateImage(device.device(), &imageInfo, nullptr, &resource.images[frame]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create render graph image");
+            }
+        }
+        vkGetImageMemoryRequirements(device.device(), resource.images[0], &resource.requirements);
+        transients.push_back(i);
+    }
+
+    std::sort(transients.begin(), transients.end(), [&](RenderResource a, RenderResource b) {
+        return resources[a].requirements.size > resources[b].requirements.size;
+    });
+
+    for (RenderResource i : transients) {
+        Resource& resource = resources[i];
+        MemoryBlock* target = nullptr;
+        for (auto& block : memoryBlocks) {
+            if ((block.memoryTypeBits & resource.requirements.memoryTypeBits) == 0) continue;
+            bool overlaps = std::any_of(block.occupants.begin(), block.occupants.end(), [&](RenderResource other) {
+                return resources[other].firstUse <= resource.lastUse && resource.firstUse <= resources[other].lastUse;
+            });
+            if (!overlaps) {
+                target = &block;
+                break;
+            }
+        }
+        if (!target) {
+            memoryBlocks.emplace_back();
+            target = &memoryBlocks.back();
+        }
+        target->size = std::max(target->size, resource.requirements.size);
+        target->memoryTypeBits &= resource.requirements.memoryTypeBits;
+        target->occupants.push_back(i);
+    }
+
+    for (auto& block : memoryBlocks) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = block.size;
+        allocInfo.memoryTypeIndex = device.findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        for (int frame = 0; frame < SwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+            if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &block.memory[frame]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate render graph memory");
+            }
+            device.memoryTracker().track(block.memory[frame], allocInfo.allocationSize, allocInfo.memoryTypeIndex, MemoryCategory::Attachment);
+            for (RenderResource i : block.occupants) {
+                Resource& resource = resources[i];
+                if (vkBindImageMemory(device.device(), resource.images[frame], block.memory[frame], 0) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to bind render graph image memory");
+                }
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = resource.images[frame];
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = resource.desc.format;
+                viewInfo.subresourceRange.aspectMask = resource.aspect;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.layerCount = 1;
+                if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.views[frame]) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create render graph image view");
+                }
+            }
+        }
+    }
+}
+
+// Replays the frame against the tracked state of every resource. A barrier is only added for
+// read after write, write after write, write after read (execution only) and layout changes,
+// and a read that the last write was already made visible to needs nothing.
+void RenderGraph::computeBarriers() {
+    std::vector<ResourceState> states(resources.size());
+
+    // a transient starts where the previous occupant of its memory left off, so reusing the
+    // memory waits for the last use of the image that was there before
+    std::vector<RenderResource> previousOccupant(resources.size(), UINT32_MAX);
+    for (auto& block : memoryBlocks) {
+        auto occupants = block.occupants;
+        std::sort(occupants.begin(), occupants.end(), [&](RenderResource a, RenderResource b) {
+            return resources[a].firstUse < resources[b].firstUse;
+        });
+        for (size_t i = 1; i < occupants.size(); i++) {
+            previousOccupant[occupants[i]] = occupants[i - 1];
+        }
+    }
+
+    passBarriers.assign(order.size(), BarrierBatch{});
+    for (uint32_t position = 0; position < order.size(); position++) {
+        BarrierBatch& batch = passBarriers[position];
+        for (auto& access : passes[order[position]].accesses) {
+            const Resource& resource = resources[access.resource];
+            ResourceState& state = states[access.resource];
+            UsageInfo info = usageInfo(access.usage);
+
+            if (!resource.imported && position == resource.firstUse) {
+                assert(access.write && "Transient image is read before it is written");
+                if (previousOccupant[access.resource] != UINT32_MAX) {
+                    const ResourceState& previous = states[previousOccupant[access.resource]];
+                    state.writeStages = previous.writeStages | previous.readStages;
+                    state.writeAccess = previous.writeAccess;
+                }
+            }
+
+            bool layoutChange = resource.image && !info.attachment && state.layout != info.layout;
+            bool hazard = false;
+            VkPipelineStageFlags srcStages = 0;
+            VkAccessFlags srcAccess = 0;
+            if (access.write) {
+                // write after write, or the write must wait for reads that came before it
+                if (state.writeStages || layoutChange) {
+                    hazard = true;
+                    srcStages = state.writeStages | state.readStages;
+                    srcAccess = state.writeAccess;
+                } else if (state.readStages) {
+                    batch.srcStages |= state.readStages;
+                    batch.dstStages |= info.stages;
+                }
+            } else {
+                bool visible = (state.visibleStages & info.stages) == info.stages &&
+                    (state.visibleAccess & info.access) == info.access;
+                if ((state.writeStages && !visible) || layoutChange) {
+                    hazard = true;
+                    srcStages = state.writeStages | (layoutChange ? state.readStages : 0);
+                    srcAccess = state.writeAccess;
+                }
+            }
+
+            if (hazard) {
+                batch.srcStages |= srcStages ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                batch.dstStages |= info.stages;
+                VkImageLayout newLayout = layoutChange ? info.layout : state.layout;
+                if (resource.image) {
+                    batch.images.push_back({access.resource, srcAccess, info.access, state.layout, newLayout});
+                } else {
+                    batch.buffers.push_back({access.resource, srcAccess, info.access});
+                }
+            }
+
+            if (access.write) {
+                state.writeStages = info.stages;
+                state.writeAccess = info.access & WRITE_ACCESS_MASK;
+                state.readStages = 0;
+                state.visibleStages = 0;
+                state.visibleAccess = 0;
+                if (info.attachment) {
+                    state.layout = access.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED ? access.finalLayout : info.layout;
+                } else {
+                    state.layout = info.layout;
+                }
+            } else {
+                if (layoutChange) {
+                    state.visibleStages = 0;
+                    state.visibleAccess = 0;
+                    state.layout = info.layout;
+                }
+                state.readStages |= info.stages;
+                state.visibleStages |= info.stages;
+                state.visibleAccess |= info.access;
+            }
+        }
+    }
+
+    finalBarriers = BarrierBatch{};
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (!resource.hasFinalUsage) continue;
+        UsageInfo info = usageInfo(resource.finalUsage);
+        const ResourceState& state = states[i];
+        if (state.layout == info.layout) continue;
+        VkPipelineStageFlags srcStages = state.writeStages | state.readStages;
+        finalBarriers.srcStages |= srcStages ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        finalBarriers.dstStages |= info.stages;
+        finalBarriers.images.push_back({i, state.writeAccess, info.access, state.layout, info.layout});
+    }
+}
+
+void RenderGraph::destroyCompiled() {
+    for (auto& resource : resources) {
+        for (int frame = 0; frame < SwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+            if (resource.views[frame] != VK_NULL_HANDLE) {
+                vkDestroyImageView(device.device(), resource.views[frame], nullptr);
+            }
+            if (resource.images[frame] != VK_NULL_HANDLE) {
+                vkDestroyImage(device.device(), resource.images[frame], nullptr);
+            }
+        }
+        resource.views.fill(VK_NULL_HANDLE);
+        resource.images.fill(VK_NULL_HANDLE);
+    }
+    for (auto& block : memoryBlocks) {
+        for (auto memory : block.memory) {
+            if (memory != VK_NULL_HANDLE) {
+                device.freeMemory(memory);
+            }
+        }
+    }
+    memoryBlocks.clear();
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch, int frameIndex) {
+    if (batch.empty()) return;
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for (auto& barrier : batch.images) {
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = barrier.srcAccess;
+        imageBarrier.dstAccessMask = barrier.dstAccess;
+        imageBarrier.oldLayout = barrier.oldLayout;
+        imageBarrier.newLayout = barrier.newLayout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = imageFor(barrier.resource, frameIndex);
+        imageBarrier.subresourceRange.aspectMask = resources[barrier.resource].aspect;
+        imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    for (auto& barrier : batch.buffers) {
+        VkBufferMemoryBarrier bufferBarrier{};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = barrier.srcAccess;
+        bufferBarrier.dstAccessMask = barrier.dstAccess;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.buffer = resources[barrier.resource].importedBuffer;
+        bufferBarrier.offset = 0;
+        bufferBarrier.size = VK_WHOLE_SIZE;
+        bufferBarriers.push_back(bufferBarrier);
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        batch.srcStages,
+        batch.dstStages,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void RenderGraph::execute(FrameInfo& frameInfo) {
+    VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+    int frameIndex = frameInfo.frameIndex;
+
+    for (uint32_t position = 0; position < order.size(); position++) {
+        recordBarriers(commandBuffer, passBarriers[position], frameIndex);
+        const Pass& pass = passes[order[position]];
+        GpuProfiler::Scope scope{frameInfo.profiler, commandBuffer, pass.name};
+        pass.execute(frameInfo);
+    }
+    recordBarriers(commandBuffer, finalBarriers, frameIndex);
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Device.hpp"
+#include "FrameInfo.hpp"
+#include "SwapChain.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using RenderResource = uint32_t;
+
+// How a pass touches a resource. Each usage implies the pipeline stages, access flags and,
+// for images, the layout the graph puts in place before the pass runs.
+enum class ResourceUsage {
+    ColorAttachment,
+    DepthAttachment,
+    SampledFragment,
+    SampledCompute,
+    StorageReadVertex,
+    StorageReadFragment,
+    StorageReadCompute,
+    StorageWriteCompute,
+    TransferSrc,
+    TransferDst,
+    Present
+};
+
+struct TransientImageDesc {
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageUsageFlags usage;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+};
+
+// Frame described as passes that declare their reads and writes. compile() drops passes whose
+// results are never used, works out the barriers every pass needs from those declarations and
+// lets transient images with disjoint lifetimes share memory. Passes run in the order they were
+// added, which defines what each read observes.
+class RenderGraph {
+    public:
+        using ExecuteFn = std::function<void(FrameInfo&)>;
+
+        class PassBuilder {
+            public:
+                PassBuilder& read(RenderResource resource, ResourceUsage usage);
+                // Attachments are transitioned by the pass's own render pass, finalLayout is the
+                // layout it leaves them in. Other usages get their layout from the graph.
+                PassBuilder& write(RenderResource resource, ResourceUsage usage, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+            private:
+                friend class RenderGraph;
+                PassBuilder(RenderGraph& graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+                RenderGraph& graph;
+                uint32_t pass;
+        };
+
+        RenderGraph(Device& device);
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // Resources owned elsewhere, their handles are bound every frame with setImage / setBuffer.
+        // Imported images start each frame with undefined contents.
+        RenderResource importImage(const std::string& name, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+        RenderResource importBuffer(const std::string& name);
+        // Images that only live within a frame, one set per frame in flight
+        RenderResource createImage(const std::string& name, const TransientImageDesc& desc);
+        // Usage an imported image is left in at the end of the frame
+        void setFinalUsage(RenderResource resource, ResourceUsage usage);
+
+        PassBuilder addPass(const std::string& name, ExecuteFn execute);
+
+        // Culls unused passes, places transient images and precomputes every barrier.
+        // Recreates GPU objects, so the device must be idle when compiling again.
+        void compile();
+
+        void setImage(RenderResource resource, VkImage image);
+        void setBuffer(RenderResource resource, VkBuffer buffer);
+        VkImageView getImageView(RenderResource resource, int frameIndex) const;
+
+        // Records every live pass with its barriers into frameInfo.commandBuffer, each pass in
+        // its own scope of frameInfo.profiler
+        void execute(FrameInfo& frameInfo);
+
+        // Compiles a small graph whose transients must share memory, throws if they do not
+        static void checkAliasing(Device& device);
+
+        size_t livePassCount() const { return order.size(); }
+        size_t transientMemoryBlocks() const { return memoryBlocks.size(); }
+
+    private:
+        struct Access {
+            RenderResource resource;
+            ResourceUsage usage;
+            bool write;
+            VkImageLayout finalLayout;
+        };
+
+        struct Pass {
+            std::string name;
+            ExecuteFn execute;
+            std::vector<Access> accesses;
+        };
+
+        struct Resource {
+            std::string name;
+            bool imported;
+            bool image;
+            VkImageAspectFlags aspect;
+            TransientImageDesc desc{};
+            bool hasFinalUsage{false};
+            ResourceUsage finalUsage{ResourceUsage::Present};
+
+            VkImage importedImage{VK_NULL_HANDLE};
+            VkBuffer importedBuffer{VK_NULL_HANDLE};
+
+            // transient images, one per frame in flight
+            std::array<VkImage, SwapChain::MAX_FRAMES_IN_FLIGHT> images{};
+            std::array<VkImageView, SwapChain::MAX_FRAMES_IN_FLIGHT> views{};
+            VkMemoryRequirements requirements{};
+            uint32_t firstUse{UINT32_MAX};
+            uint32_t lastUse{0};
+        };
+
+        struct MemoryBlock {
+            std::array<VkDeviceMemory, SwapChain::MAX_FRAMES_IN_FLIGHT> memory{};
+            VkDeviceSize size{0};
+            uint32_t memoryTypeBits{~0u};
+            std::vector<RenderResource> occupants;
+        };
+
+        struct ImageBarrier {
+            RenderResource resource;
+            VkAccessFlags srcAccess;
+            VkAccessFlags dstAccess;
+            VkImageLayout oldLayout;
+            VkImageLayout newLayout;
+        };
+
+        struct BufferBarrier {
+            RenderResource resource;
+            VkAccessFlags srcAccess;
+            VkAccessFlags dstAccess;
+        };
+
+        // everything recorded in front of one pass, in a single vkCmdPipelineBarrier
+        struct BarrierBatch {
+            VkPipelineStageFlags srcStages{0};
+            VkPipelineStageFlags dstStages{0};
+            std::vector<ImageBarrier> images;
+            std::vector<BufferBarrier> buffers;
+
+            bool empty() const { return srcStages == 0 && dstStages == 0; }
+        };
+
+        void cullPasses();
+        void computeLifetimes();
+        void allocateTransients();
+        void computeBarriers();
+        void destroyCompiled();
+        void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch, int frameIndex);
+        VkImage imageFor(RenderResource resource, int frameIndex) const;
+
+        Device& device;
+        std::vector<Resource> resources;
+        std::vector<Pass> passes;
+
+        // compiled state
+        std::vector<uint32_t> order;
+        std::vector<BarrierBatch> passBarriers;
+        BarrierBatch finalBarriers;
+        std::vector<MemoryBlock> memoryBlocks;
+};
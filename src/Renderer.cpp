@@ -1,36 +1,71 @@
 #include "Renderer.hpp"
+#include "Buffer.hpp"
+#include "ImageExport.hpp"
+#include "CpuProfiler.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 #include <array>
+#include <iostream>
 
-Renderer::Renderer(Window& window, Device& device) : window{window}, device{device} {
-    recreateSwapChain();
-    createCommandBuffers();
-}
+// how long beginFrame idles for window events while there is nothing to present to
+#define MINIMIZED_WAIT_SECONDS 0.05
 
-Renderer::~Renderer() { freeCommandBuffers(); }
+Renderer::Renderer(Window& window, Device& device, RenderPath renderPath, bool dynamicRendering)
+    : window{window}, device{device}, renderPath{renderPath}, dynamicRendering{false} {
+    if (dynamicRendering) {
+        if (renderPath != RenderPath::Forward) {
+            std::cout << "Dynamic rendering is only used on the forward path, keeping render passes" << std::endl;
+        } else if (!device.supportsDynamicRendering()) {
+            std::cout << "Device does not support dynamic rendering, keeping render passes" << std::endl;
+        } else {
+            this->dynamicRendering = true;
+        }
+    }
 
-void Renderer::recreateSwapChain() {
     auto extent = window.getExtent();
     while (extent.width == 0 || extent.height == 0) {
         extent = window.getExtent();
         glfwWaitEvents();
     }
+    swapChain = std::make_unique<SwapChain>(device, extent, renderPath, this->dynamicRendering);
+    createCommandBuffers();
+}
+
+Renderer::~Renderer() { freeCommandBuffers(); }
 
-    vkDeviceWaitIdle(device.device());
+// Replaces the swapchain without draining the GPU. Returns false while the window has no
+// area to present to, the swapchain stays outdated until it has.
+bool Renderer::recreateSwapChain() {
+    PROFILE_SCOPE("recreate swapchain");
+    auto extent = window.getExtent();
+    if (extent.width == 0 || extent.height == 0) {
+        return false;
+    }
 
-    if(swapChain == nullptr) {
-        swapChain = std::make_unique<SwapChain>(device, extent);
-    } else {
-        std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-        swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain);
+    std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
+    swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain, renderPath, dynamicRendering);
 
-        if(!oldSwapChain->compareSwapFormats(*swapChain.get())) {
-            throw std::runtime_error("Swap chain image(or depth) format has changed!");
-        }
+    if(!oldSwapChain->compareSwapFormats(*swapChain.get())) {
+        throw std::runtime_error("Swap chain image(or depth) format has changed!");
     }
 
-    //come back
+    retiredSwapChains.push_back({std::move(oldSwapChain), framesSubmitted});
+    swapChainOutdated = false;
+    return true;
+}
+
+// Called after the current frame slot's fence was waited on. Fences are waited on in
+// submission order, so every frame but the newest MAX_FRAMES_IN_FLIGHT - 1 has completed.
+void Renderer::releaseRetiredSwapChains() {
+    uint64_t completedFrames = framesSubmitted + 1 >= SwapChain::MAX_FRAMES_IN_FLIGHT
+        ? framesSubmitted + 1 - SwapChain::MAX_FRAMES_IN_FLIGHT
+        : 0;
+    retiredSwapChains.erase(
+        std::remove_if(retiredSwapChains.begin(), retiredSwapChains.end(), [&](const RetiredSwapChain& retired) {
+            return retired.framesSubmitted <= completedFrames;
+        }),
+        retiredSwapChains.end());
 }
 
 void Renderer::createCommandBuffers(){
@@ -53,11 +88,19 @@ void Renderer::freeCommandBuffers() {
 }
 
 VkCommandBuffer Renderer::beginFrame() {
+    PROFILE_SCOPE("begin frame");
     assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+    if (swapChainOutdated && !recreateSwapChain()) {
+        // minimized, skip the frame without blocking the loop indefinitely
+        glfwWaitEventsTimeout(MINIMIZED_WAIT_SECONDS);
+        return nullptr;
+    }
+
     auto result = swapChain->acquireNextImage(&currentImageIndex);
+    releaseRetiredSwapChains();
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapChain();
+        swapChainOutdated = true;
         return nullptr;
     }
     if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
@@ -76,15 +119,19 @@ VkCommandBuffer Renderer::beginFrame() {
     return commandBuffer;
 }
 void Renderer::endFrame() {
+    PROFILE_SCOPE("end frame");
     assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
     auto commandBuffer = getCurrentCommandBuffer();
     if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("Failed to end command buffer");
     }
     auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+    framesSubmitted++;
+    lastSubmittedImage = currentImageIndex;
     if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasWindowResized()) {
         window.resetWindowResizedFlag();
-        recreateSwapChain();
+        // recreated at the start of the next frame, which also covers a minimized window
+        swapChainOutdated = true;
     } else if(result != VK_SUCCESS) {
         throw std::runtime_error("Failed to present swap chain image");
     }
@@ -93,9 +140,14 @@ void Renderer::endFrame() {
     currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
-void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from different frame");
+    if (dynamicRendering) {
+        beginDynamicRendering(commandBuffer, contents);
+        return;
+    }
+
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = swapChain->getRenderPass();
@@ -104,14 +156,92 @@ void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     renderPassInfo.renderArea.offset = {0,0};
     renderPassInfo.renderArea.extent = swapChain->getSwapChainExtent();
 
-    std::array<VkClearValue, 2> clearValues{};
+    // attachments past the depth buffer are g-buffer targets and clear to zero
+    std::vector<VkClearValue> clearValues(swapChain->attachmentCount());
     clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
     clearValues[1].depthStencil = {1.0f, 0};
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+    // secondaries set their own
+    if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+        setViewportAndScissor(commandBuffer);
+    }
+}
+
+// Same attachments, clears and layouts as the forward render pass, with the transitions the
+// render pass would have made recorded by hand
+void Renderer::beginDynamicRendering(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+    VkFormat depthFormat = swapChain->getRenderTarget().depthFormat;
+    VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) {
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask = 0;
+    barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image = swapChain->getImage(currentImageIndex);
+    barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
 
+    barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].image = swapChain->getDepthImage(currentImageIndex);
+    barriers[1].subresourceRange = {depthAspect, 0, 1, 0, 1};
+
+    // the color write waits on the acquire semaphore's stage, depth on the previous frame's tests
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+        0, 0, nullptr, 0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    VkRenderingAttachmentInfo colorAttachment{};
+    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    colorAttachment.imageView = swapChain->getImageView(currentImageIndex);
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue.color = {0.01f, 0.01f, 0.01f, 1.0f};
+
+    VkRenderingAttachmentInfo depthAttachment{};
+    depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depthAttachment.imageView = swapChain->getDepthImageView(currentImageIndex);
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue.depthStencil = {1.0f, 0};
+
+    VkRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.renderArea = {{0, 0}, swapChain->getSwapChainExtent()};
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+    if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+        renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+    }
+
+    device.cmdBeginRendering(commandBuffer, &renderingInfo);
+    if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+        setViewportAndScissor(commandBuffer);
+    }
+}
+
+void Renderer::setViewportAndScissor(VkCommandBuffer commandBuffer) {
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -122,11 +252,79 @@ void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     VkRect2D scissor{{0,0}, swapChain->getSwapChainExtent()};
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+SecondaryTarget Renderer::getSecondaryTarget(uint32_t subpass) const {
+    assert(isFrameStarted && "Cannot get secondary target when frame not in progress");
+    RenderTarget target = swapChain->getRenderTarget();
+    SecondaryTarget secondary{};
+    if (!dynamicRendering) {
+        secondary.renderPass = target.renderPass;
+        secondary.subpass = subpass;
+        secondary.framebuffer = swapChain->getFrameBuffer(currentImageIndex);
+    }
+    secondary.colorFormat = target.colorFormat;
+    secondary.depthFormat = target.depthFormat;
+    secondary.extent = swapChain->getSwapChainExtent();
+    return secondary;
+}
 
+void Renderer::nextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+    assert(isFrameStarted && "Can't call nextSubpass if frame is not in progress");
+    assert(commandBuffer == getCurrentCommandBuffer() && "Can't advance render pass on command buffer from different frame");
+    vkCmdNextSubpass(commandBuffer, contents);
+    // executing secondaries leaves the primary's dynamic state undefined
+    if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+        setViewportAndScissor(commandBuffer);
+    }
 }
 
 void Renderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from different frame");
-    vkCmdEndRenderPass(commandBuffer);
-}
\ No newline at end of file
+    if (!dynamicRendering) {
+        vkCmdEndRenderPass(commandBuffer);
+        return;
+    }
+
+    device.cmdEndRendering(commandBuffer);
+
+    // leave the image ready to present or copy, as the render pass's final layout did
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = swapChain->getFinalLayout();
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = swapChain->getImage(currentImageIndex);
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void Renderer::captureLastFrame(const std::string& path) {
+    assert(!isFrameStarted && "Can't capture while a frame is in progress");
+    if (!device.isHeadless()) {
+        throw std::runtime_error("Frame capture is only supported when rendering headless");
+    }
+    if (framesSubmitted == 0) {
+        throw std::runtime_error("No frame has been rendered to capture");
+    }
+
+    VkExtent2D extent = swapChain->getSwapChainExtent();
+    Buffer readback{
+        device,
+        4,
+        extent.width * extent.height,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+    device.copyImageToBuffer(swapChain->getImage(lastSubmittedImage), readback.getBuffer(), extent.width, extent.height);
+
+    readback.map();
+    writePPM(path, extent.width, extent.height, static_cast<const uint8_t*>(readback.getMappedMemory()));
+}
@@ -3,22 +3,41 @@
 #include "Window.hpp"
 #include "Device.hpp"
 #include "SwapChain.hpp"
+#include "SecondaryCommandBuffers.hpp"
 #include <memory>
+#include <string>
 #include <vector>
 #include <cassert>
 
 class Renderer{
         public:
 
-        Renderer(Window& window, Device& device);
+        // dynamicRendering is a request, it falls back to render passes on the deferred path or
+        // when the device lacks the feature
+        Renderer(Window& window, Device& device, RenderPath renderPath = RenderPath::Forward, bool dynamicRendering = false);
         ~Renderer();
 
         Renderer(const Renderer&) = delete;
         Renderer& operator=(const Renderer &) = delete;
 
         VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); }
+        RenderTarget getSwapChainRenderTarget() const { return swapChain->getRenderTarget(); }
+        bool usesDynamicRendering() const { return dynamicRendering; }
+        VkImageLayout getSwapChainFinalLayout() const { return swapChain->getFinalLayout(); }
         float getAspectRatio() const { return swapChain->extentAspectRatio(); }
+        VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); }
         bool isFrameInProgress() const { return isFrameStarted; }
+        RenderPath getRenderPath() const { return renderPath; }
+
+        GBufferViews getCurrentGBufferViews() const {
+            assert(isFrameStarted && "Cannot get g-buffer when frame not in progress");
+            return swapChain->getGBufferViews(currentImageIndex);
+        }
+
+        VkImage getCurrentSwapChainImage() const {
+            assert(isFrameStarted && "Cannot get swap chain image when frame not in progress");
+            return swapChain->getImage(currentImageIndex);
+        }
 
         VkCommandBuffer getCurrentCommandBuffer() const { 
             assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
@@ -30,21 +49,47 @@ class Renderer{
             return currentFrameIndex;
         }
 
+        // Returns nullptr when no frame can be recorded, e.g. while the window is minimized
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the subpass may only execute
+        // secondaries begun against getSecondaryTarget
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        void nextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // Writes the image of the last submitted frame to a PPM file. Only headless images can
+        // be read back, and the device must be idle.
+        void captureLastFrame(const std::string& path);
+
+        SecondaryTarget getSecondaryTarget(uint32_t subpass) const;
+
     private:
+        void beginDynamicRendering(VkCommandBuffer commandBuffer, VkSubpassContents contents);
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
         void createCommandBuffers();
         void freeCommandBuffers();
-        void recreateSwapChain();
+        bool recreateSwapChain();
+        void releaseRetiredSwapChains();
 
         Window& window;
         Device& device;
+        RenderPath renderPath;
+        bool dynamicRendering;
         std::unique_ptr<SwapChain> swapChain;
         std::vector<VkCommandBuffer> commandBuffers;
 
+        // Replaced swapchains whose images frames in flight may still render into. Each is
+        // destroyed once the fences of every frame submitted before it was replaced were waited on.
+        struct RetiredSwapChain {
+            std::shared_ptr<SwapChain> swapChain;
+            uint64_t framesSubmitted;
+        };
+        std::vector<RetiredSwapChain> retiredSwapChains;
+        uint64_t framesSubmitted{0};
+        uint32_t lastSubmittedImage{0};
+        bool swapChainOutdated{false};
+
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
         bool isFrameStarted{false};
@@ -0,0 +1,193 @@
+#include "SceneGraph.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+// below this many nodes per job a level is processed on the calling thread
+#define MIN_NODES_PER_JOB 2048
+#define INVALID_SLOT UINT32_MAX
+
+void SceneGraph::setParent(Entity entity, Entity parent) {
+    if (entity == NULL_ENTITY) {
+        throw std::invalid_argument("Cannot add the null entity to the scene graph");
+    }
+    if (parent == entity) {
+        throw std::invalid_argument("Cannot parent an entity to itself");
+    }
+    // walking up from the new parent must never reach entity, or the hierarchy would cycle
+    if (parent != NULL_ENTITY && contains(parent)) {
+        for (Entity ancestor = parent; ancestor != NULL_ENTITY; ancestor = getParent(ancestor)) {
+            if (ancestor == entity) {
+                throw std::invalid_argument("Cannot parent an entity to one of its descendants");
+            }
+        }
+    }
+
+    uint32_t index = entity & ENTITY_INDEX_MASK;
+    if (index >= nodes.size()) {
+        nodes.resize(index + 1);
+    }
+    Node& node = nodes[index];
+    if (node.entity != entity) {
+        // the index may still hold a destroyed entity that update has not pruned yet, its
+        // parent and children must not keep pointing at the slot once it is reused
+        if (node.entity != NULL_ENTITY) {
+            remove(node.entity);
+        }
+        node.entity = entity;
+    }
+
+    if (parent != NULL_ENTITY) {
+        if (!contains(parent)) {
+            setParent(parent);
+        }
+    }
+
+    Node& current = nodes[index];
+    detachFromParent(current);
+    current.parent = parent;
+    if (parent != NULL_ENTITY) {
+        findNode(parent)->children.push_back(entity);
+    }
+    orderDirty = true;
+}
+
+void SceneGraph::remove(Entity entity) {
+    Node* node = findNode(entity);
+    if (node == nullptr) return;
+    detachFromParent(*node);
+    for (Entity child : node->children) {
+        findNode(child)->parent = NULL_ENTITY;
+    }
+    *node = Node{};
+    orderDirty = true;
+}
+
+bool SceneGraph::contains(Entity entity) const {
+    return findNode(entity) != nullptr;
+}
+
+Entity SceneGraph::getParent(Entity entity) const {
+    const Node* node = findNode(entity);
+    assert(node != nullptr && "Entity is not part of the scene graph");
+    return node->parent;
+}
+
+const std::vector<Entity>& SceneGraph::getChildren(Entity entity) const {
+    const Node* node = findNode(entity);
+    assert(node != nullptr && "Entity is not part of the scene graph");
+    return node->children;
+}
+
+SceneGraph::Node* SceneGraph::findNode(Entity entity) {
+    uint32_t index = entity & ENTITY_INDEX_MASK;
+    if (entity == NULL_ENTITY || index >= nodes.size() || nodes[index].entity != entity) return nullptr;
+    return &nodes[index];
+}
+
+const SceneGraph::Node* SceneGraph::findNode(Entity entity) const {
+    return const_cast<SceneGraph*>(this)->findNode(entity);
+}
+
+void SceneGraph::detachFromParent(Node& node) {
+    if (node.parent == NULL_ENTITY) return;
+    auto& siblings = findNode(node.parent)->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node.entity));
+    node.parent = NULL_ENTITY;
+}
+
+void SceneGraph::rebuildOrder() {
+    order.clear();
+    parentSlots.clear();
+    levelOffsets.clear();
+    slotOf.assign(nodes.size(), INVALID_SLOT);
+
+    for (auto& node : nodes) {
+        if (node.entity != NULL_ENTITY && node.parent == NULL_ENTITY) {
+            slotOf[node.entity & ENTITY_INDEX_MASK] = static_cast<uint32_t>(order.size());
+            order.push_back(node.entity);
+            parentSlots.push_back(INVALID_SLOT);
+        }
+    }
+
+    // breadth first, each pass appends the next level after the current one
+    size_t levelBegin = 0;
+    while (levelBegin < order.size()) {
+        levelOffsets.push_back(static_cast<uint32_t>(levelBegin));
+        size_t levelEnd = order.size();
+        for (size_t slot = levelBegin; slot < levelEnd; slot++) {
+            for (Entity child : nodes[order[slot] & ENTITY_INDEX_MASK].children) {
+                slotOf[child & ENTITY_INDEX_MASK] = static_cast<uint32_t>(order.size());
+                order.push_back(child);
+                parentSlots.push_back(static_cast<uint32_t>(slot));
+            }
+        }
+        levelBegin = levelEnd;
+    }
+    levelOffsets.push_back(static_cast<uint32_t>(order.size()));
+
+    // every slot moved, so every world matrix has to be rebuilt once
+    localVersions.assign(order.size(), 0);
+    worldMatrices.resize(order.size());
+    worldNormalMatrices.resize(order.size());
+    orderDirty = false;
+}
+
+void SceneGraph::update(Registry& registry) {
+    // entities destroyed in the registry drop out, their children become roots
+    for (auto& node : nodes) {
+        if (node.entity != NULL_ENTITY && !registry.valid(node.entity)) {
+            remove(node.entity);
+        }
+    }
+    if (orderDirty) {
+        rebuildOrder();
+    }
+
+    auto& transforms = registry.pool<TransformComponent>();
+    dirty.assign(order.size(), 0);
+
+    for (size_t level = 0; level + 1 < levelOffsets.size(); level++) {
+        uint32_t levelBegin = levelOffsets[level];
+        uint32_t levelEnd = levelOffsets[level + 1];
+        // parents are finished before their level starts, so slots within a level are independent
+        JobSystem::shared().parallelFor(levelEnd - levelBegin, MIN_NODES_PER_JOB, [&](size_t begin, size_t end) {
+            for (size_t slot = levelBegin + begin; slot < levelBegin + end; slot++) {
+                Entity entity = order[slot];
+                uint32_t parentSlot = parentSlots[slot];
+                bool parentDirty = parentSlot != INVALID_SLOT && dirty[parentSlot];
+
+                TransformComponent* transform = transforms.contains(entity) ? &transforms.get(entity) : nullptr;
+                // mat4() is what refreshes the version, so it has to run before the comparison
+                const glm::mat4 identity{1.f};
+                const glm::mat4& local = transform ? transform->mat4() : identity;
+                uint64_t version = transform ? transform->getVersion() : 1;
+                if (!parentDirty && version == localVersions[slot]) continue;
+
+                dirty[slot] = 1;
+                localVersions[slot] = version;
+                glm::mat3 localNormal = transform ? transform->normalMatrix() : glm::mat3{1.f};
+                if (parentSlot == INVALID_SLOT) {
+                    worldMatrices[slot] = local;
+                    worldNormalMatrices[slot] = localNormal;
+                } else {
+                    // the inverse transpose of a product is the product of the inverse transposes
+                    worldMatrices[slot] = worldMatrices[parentSlot] * local;
+                    worldNormalMatrices[slot] = worldNormalMatrices[parentSlot] * localNormal;
+                }
+            }
+        });
+    }
+}
+
+const glm::mat4& SceneGraph::worldMatrix(Entity entity) const {
+    assert(!orderDirty && contains(entity) && "Scene graph must be updated after changing the hierarchy");
+    return worldMatrices[slotOf[entity & ENTITY_INDEX_MASK]];
+}
+
+const glm::mat3& SceneGraph::worldNormalMatrix(Entity entity) const {
+    assert(!orderDirty && contains(entity) && "Scene graph must be updated after changing the hierarchy");
+    return worldNormalMatrices[slotOf[entity & ENTITY_INDEX_MASK]];
+}
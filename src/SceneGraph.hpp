@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Registry.hpp"
+#include "Components.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Transform hierarchy over registry entities. TransformComponent holds the local transform,
+// world matrices live here in flat arrays sorted breadth first, so every parent precedes its
+// children and each depth level is a contiguous range that can be processed in parallel.
+class SceneGraph {
+    public:
+        // Adds entity as a root, or moves it under parent. The local transform is kept as is,
+        // so the world transform changes with the new parent. Throws std::invalid_argument
+        // when parent is entity itself or one of its descendants.
+        void setParent(Entity entity, Entity parent = NULL_ENTITY);
+        // Removes entity from the hierarchy, its children become roots
+        void remove(Entity entity);
+
+        bool contains(Entity entity) const;
+        Entity getParent(Entity entity) const;
+        const std::vector<Entity>& getChildren(Entity entity) const;
+
+        // Recomputes world matrices of every subtree whose local transforms changed
+        void update(Registry& registry);
+
+        // Valid after update, entities outside the graph are not allowed
+        const glm::mat4& worldMatrix(Entity entity) const;
+        const glm::mat3& worldNormalMatrix(Entity entity) const;
+        glm::vec3 worldPosition(Entity entity) const { return glm::vec3(worldMatrix(entity)[3]); }
+
+        size_t size() const { return order.size(); }
+        size_t levelCount() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+
+    private:
+        struct Node {
+            Entity entity = NULL_ENTITY;
+            Entity parent = NULL_ENTITY;
+            std::vector<Entity> children;
+        };
+
+        Node* findNode(Entity entity);
+        const Node* findNode(Entity entity) const;
+        void detachFromParent(Node& node);
+        void rebuildOrder();
+
+        // hierarchy, indexed by entity index
+        std::vector<Node> nodes;
+        bool orderDirty{false};
+
+        // breadth first arrays rebuilt when the hierarchy changes
+        std::vector<Entity> order;
+        std::vector<uint32_t> parentSlots;
+        std::vector<uint32_t> levelOffsets;
+        std::vector<uint32_t> slotOf; // entity index -> slot in order
+        std::vector<uint64_t> localVersions;
+        std::vector<uint8_t> dirty;
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<glm::mat3> worldNormalMatrices;
+};
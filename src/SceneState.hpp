@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Registry.hpp"
+#include "Model.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// World space scene data the render thread draws from. Produced by Simulation, which owns the
+// registry, so rendering never touches components directly.
+struct RenderObject {
+    Entity entity;
+    Model* model;
+    glm::mat4 modelMatrix;
+    glm::mat3 normalMatrix;
+};
+
+struct RenderLight {
+    Entity entity;
+    glm::vec3 position;
+    glm::vec3 color;
+    float intensity;
+    float radius; // size of the drawn billboard
+};
+
+struct SceneState {
+    std::vector<RenderObject> objects;
+    std::vector<RenderLight> lights;
+    double time{0.0}; // simulation time in seconds
+};
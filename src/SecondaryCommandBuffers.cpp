@@ -0,0 +1,125 @@
+#include "SecondaryCommandBuffers.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+    // threads are numbered the first time they record, job workers and the render thread alike
+    std::atomic<uint32_t> nextThreadSlot{0};
+    thread_local uint32_t threadSlot = UINT32_MAX;
+
+    uint32_t currentThreadSlot() {
+        if (threadSlot == UINT32_MAX) {
+            threadSlot = nextThreadSlot.fetch_add(1);
+        }
+        return threadSlot;
+    }
+}
+
+SecondaryCommandBuffers::SecondaryCommandBuffers(Device& device) : device{device} {}
+
+SecondaryCommandBuffers::~SecondaryCommandBuffers() {
+    for (auto& framePools : pools) {
+        for (auto& threadPool : framePools) {
+            if (threadPool) {
+                // destroying the pool frees its buffers
+                vkDestroyCommandPool(device.device(), threadPool->pool, nullptr);
+            }
+        }
+    }
+}
+
+void SecondaryCommandBuffers::beginFrame(int frameIndex) {
+    std::lock_guard<std::mutex> lock{mutex};
+    this->frameIndex = frameIndex;
+    for (auto& threadPool : pools[frameIndex]) {
+        if (threadPool && threadPool->used > 0) {
+            vkResetCommandPool(device.device(), threadPool->pool, 0);
+            threadPool->used = 0;
+        }
+    }
+}
+
+SecondaryCommandBuffers::ThreadPool& SecondaryCommandBuffers::threadPool() {
+    uint32_t slot = currentThreadSlot();
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& framePools = pools[frameIndex];
+    if (slot >= framePools.size()) {
+        framePools.resize(slot + 1);
+    }
+    if (!framePools[slot]) {
+        auto threadPool = std::make_unique<ThreadPool>();
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &threadPool->pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create secondary command pool");
+        }
+        framePools[slot] = std::move(threadPool);
+    }
+    return *framePools[slot];
+}
+
+VkCommandBuffer SecondaryCommandBuffers::begin(const SecondaryTarget& target) {
+    ThreadPool& threadPool = this->threadPool();
+    if (threadPool.used == threadPool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = threadPool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate secondary command buffer");
+        }
+        threadPool.buffers.push_back(commandBuffer);
+    }
+    VkCommandBuffer commandBuffer = threadPool.buffers[threadPool.used++];
+
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &target.colorFormat;
+    renderingInfo.depthAttachmentFormat = target.depthFormat;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = target.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
+    inheritanceInfo.renderPass = target.renderPass;
+    inheritanceInfo.subpass = target.subpass;
+    inheritanceInfo.framebuffer = target.framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin secondary command buffer");
+    }
+
+    // dynamic state is not inherited from the primary
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(target.extent.width);
+    viewport.height = static_cast<float>(target.extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{{0, 0}, target.extent};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    return commandBuffer;
+}
+
+void SecondaryCommandBuffers::end(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record secondary command buffer");
+    }
+}
+
+VkCommandBuffer SecondaryCommandBuffers::record(const SecondaryTarget& target, const std::function<void(VkCommandBuffer)>& record) {
+    VkCommandBuffer commandBuffer = begin(target);
+    record(commandBuffer);
+    end(commandBuffer);
+    return commandBuffer;
+}
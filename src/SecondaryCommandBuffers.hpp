@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Device.hpp"
+#include "SwapChain.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// What a secondary command buffer continuing the swapchain render pass inherits. With dynamic
+// rendering renderPass is null and the attachment formats describe the target instead.
+struct SecondaryTarget {
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+};
+
+// Secondary command buffers that any thread can record, so draws can be split across jobs and
+// executed from the primary with vkCmdExecuteCommands. Each recording thread gets its own
+// command pool per frame in flight, since a pool may only be used by one thread at a time.
+// Pools are reset as a whole once their frame's fence has signaled.
+class SecondaryCommandBuffers {
+    public:
+        SecondaryCommandBuffers(Device& device);
+        ~SecondaryCommandBuffers();
+
+        SecondaryCommandBuffers(const SecondaryCommandBuffers&) = delete;
+        SecondaryCommandBuffers& operator=(const SecondaryCommandBuffers&) = delete;
+
+        // Recycles every buffer recorded for frameIndex, call after Renderer::beginFrame
+        void beginFrame(int frameIndex);
+
+        // Begins a buffer from the calling thread's pool with the target's viewport and scissor
+        // already set, the pipeline and descriptor sets have to be bound again
+        VkCommandBuffer begin(const SecondaryTarget& target);
+        void end(VkCommandBuffer commandBuffer);
+
+        // begin, record, end
+        VkCommandBuffer record(const SecondaryTarget& target, const std::function<void(VkCommandBuffer)>& record);
+
+    private:
+        struct ThreadPool {
+            VkCommandPool pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> buffers;
+            size_t used{0};
+        };
+
+        ThreadPool& threadPool();
+
+        Device& device;
+        int frameIndex{0};
+        // indexed by the recording thread's slot, grown under mutex as threads first record
+        std::mutex mutex;
+        std::array<std::vector<std::unique_ptr<ThreadPool>>, SwapChain::MAX_FRAMES_IN_FLIGHT> pools;
+};
@@ -0,0 +1,128 @@
+#include "Settings.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#define BENCHMARK_DEFAULT_FRAMES 1000
+#define REPLAY_DEFAULT_FRAMES 1000
+
+namespace {
+    // flags that take the next argument as their value, as matched in fromArgs
+    bool isValueFlag(const std::string& arg) {
+        for (const char* flag : {"--frames", "--capture", "--benchmark", "--benchmark-count", "--benchmark-output", "--camera-path", "--record-camera-path", "--capture-stream", "--capture-stream-frame", "--replay", "--cpu-trace", "--tick-rate"}) {
+            if (arg == flag) return true;
+        }
+        return false;
+    }
+}
+
+Settings Settings::fromArgs(int argc, char** argv) {
+    Settings settings{};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--deferred") {
+            settings.renderPath = RenderPath::Deferred;
+        } else if (arg == "--forward") {
+            settings.renderPath = RenderPath::Forward;
+        } else if (arg == "--cpu-light-culling") {
+            settings.cpuLightCulling = true;
+        } else if (arg == "--sort-lights") {
+            settings.sortLightBillboards = true;
+        } else if (arg == "--transform-stats") {
+            settings.transformStats = true;
+        } else if (arg == "--quaternion-transforms") {
+            settings.quaternionTransforms = true;
+        } else if (arg == "--memory-report") {
+            settings.memoryReport = true;
+        } else if (arg == "--pass-timings") {
+            settings.passTimings = true;
+        } else if (arg == "--pipeline-stats") {
+            settings.passTimings = true;
+            settings.pipelineStatistics = true;
+        } else if (arg == "--dynamic-rendering") {
+            settings.dynamicRendering = true;
+        } else if (arg == "--bindless") {
+            settings.bindless = true;
+        } else if (arg == "--parallel-recording") {
+            settings.parallelRecording = true;
+        } else if (arg == "--check-aliasing") {
+            settings.checkAliasing = true;
+        } else if (arg == "--headless") {
+            settings.headless = true;
+        } else if (arg == "--fixed-timestep") {
+            settings.fixedTimestep = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            int frames = std::stoi(argv[++i]);
+            if (frames <= 0) {
+                throw std::runtime_error("--frames must be positive");
+            }
+            settings.frameCount = static_cast<uint32_t>(frames);
+        } else if (arg == "--capture" && i + 1 < argc) {
+            settings.capturePath = argv[++i];
+        } else if (arg == "--benchmark" && i + 1 < argc) {
+            settings.benchmark = true;
+            std::string scene = argv[++i];
+            if (!parseBenchmarkScene(scene, settings.benchmarkScene)) {
+                throw std::runtime_error("Unknown benchmark scene " + scene + ", expected cubes, lights or meshes");
+            }
+        } else if (arg == "--benchmark-count" && i + 1 < argc) {
+            int count = std::stoi(argv[++i]);
+            if (count <= 0) {
+                throw std::runtime_error("--benchmark-count must be positive");
+            }
+            settings.benchmarkCount = static_cast<uint32_t>(count);
+        } else if (arg == "--benchmark-output" && i + 1 < argc) {
+            settings.benchmarkOutput = argv[++i];
+        } else if (arg == "--camera-path" && i + 1 < argc) {
+            settings.cameraPath = argv[++i];
+        } else if (arg == "--record-camera-path" && i + 1 < argc) {
+            settings.recordCameraPath = argv[++i];
+        } else if (arg == "--capture-stream" && i + 1 < argc) {
+            settings.streamCapturePath = argv[++i];
+        } else if (arg == "--capture-stream-frame" && i + 1 < argc) {
+            int frame = std::stoi(argv[++i]);
+            if (frame < 0) {
+                throw std::runtime_error("--capture-stream-frame must not be negative");
+            }
+            settings.streamCaptureFrame = static_cast<uint32_t>(frame);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            settings.replayPath = argv[++i];
+        } else if (arg == "--cpu-trace" && i + 1 < argc) {
+            settings.cpuTracePath = argv[++i];
+        } else if (arg == "--tick-rate" && i + 1 < argc) {
+            settings.simulationTickRate = std::stof(argv[++i]);
+            if (settings.simulationTickRate <= 0.f) {
+                throw std::runtime_error("--tick-rate must be positive");
+            }
+        } else if (isValueFlag(arg)) {
+            // a value flag only gets here when it is the last argument
+            throw std::runtime_error(arg + " needs a value");
+        } else {
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+    if (settings.benchmark) {
+        // animation has to advance the same way in every run for numbers to compare
+        settings.fixedTimestep = true;
+        if (settings.frameCount == 0) {
+            settings.frameCount = BENCHMARK_DEFAULT_FRAMES;
+        }
+    }
+    if (!settings.replayPath.empty()) {
+        if (settings.benchmark) {
+            throw std::runtime_error("--replay draws a captured frame and cannot be combined with --benchmark");
+        }
+        settings.headless = true;
+        settings.fixedTimestep = true;
+        if (settings.frameCount == 0) {
+            settings.frameCount = REPLAY_DEFAULT_FRAMES;
+        }
+    }
+    if (settings.headless && settings.frameCount == 0) {
+        throw std::runtime_error("--headless needs --frames, nothing else ends the run");
+    }
+    if (!settings.capturePath.empty() && !settings.headless) {
+        throw std::runtime_error("--capture is only supported together with --headless");
+    }
+    return settings;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SwapChain.hpp"
+#include "Benchmark.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Startup options, parsed once from the command line in main
+struct Settings {
+    RenderPath renderPath = RenderPath::Forward;
+    bool cpuLightCulling = false;
+    bool sortLightBillboards = false;
+    bool transformStats = false; // prints cached vs recomputed transform matrices every second
+    bool quaternionTransforms = false; // scene objects use TransformComponent::orientation
+    bool memoryReport = false; // prints heap budgets and allocated bytes per category every second
+    bool passTimings = false; // prints gpu time of every render graph pass and system every second
+    bool pipelineStatistics = false; // pass timings also count vertex and fragment shader invocations
+    bool dynamicRendering = false; // forward path renders without VkRenderPass / VkFramebuffer objects
+    bool bindless = false; // point lights read their buffers by index from the bindless descriptor table
+    bool parallelRecording = false; // scene draws are recorded from jobs into secondary command buffers, without per system gpu timings
+    bool checkAliasing = false; // compiles a small render graph at startup and fails if its transients do not share memory
+    float simulationTickRate = 60.f; // fixed simulation ticks per second, independent of frame rate
+    bool headless = false; // no window or surface, frames render into offscreen images
+    uint32_t frameCount = 0; // exit after this many rendered frames, 0 runs until the window closes
+    bool fixedTimestep = false; // every frame advances exactly one simulation tick, for reproducible runs
+    std::string capturePath; // headless only, the last frame is written here as a PPM
+    bool benchmark = false; // replaces the scene with benchmarkScene and reports frame times as JSON
+    BenchmarkScene benchmarkScene = BenchmarkScene::Cubes;
+    uint32_t benchmarkCount = 0; // scene size, 0 uses the scene's default
+    std::string benchmarkOutput = "benchmark.json";
+    std::string cameraPath; // camera follows this recorded path instead of keyboard input
+    std::string recordCameraPath; // keyboard driven camera is written here on exit
+    std::string streamCapturePath; // the draw stream and scene of one frame are saved here for --replay
+    uint32_t streamCaptureFrame = 0; // which rendered frame --capture-stream saves
+    std::string replayPath; // headless, draws a --capture-stream file every frame instead of the scene
+    std::string cpuTracePath; // cpu zones are recorded and written here as Chrome trace JSON on exit
+
+    static Settings fromArgs(int argc, char** argv);
+};
@@ -0,0 +1,159 @@
+#include "Simulation.hpp"
+#include "Components.hpp"
+#include "CpuProfiler.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+// after falling this many ticks behind, the backlog is dropped instead of replayed
+#define MAX_CATCH_UP_TICKS 5
+
+Simulation::Simulation(Registry& registry, SceneGraph& sceneGraph, float tickRate)
+    : registry{registry}, sceneGraph{sceneGraph}, tickInterval{1.f / tickRate} {
+    assert(tickRate > 0.f && "Simulation tick rate must be positive");
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start(bool threaded) {
+    if (started) return;
+    started = true;
+    this->threaded = threaded;
+
+    // both buffers hold the starting state, so sampling works before the first tick
+    TransformComponent::updateCaches(registry.pool<TransformComponent>().getComponents());
+    sceneGraph.update(registry);
+    capture(current);
+    previous = current;
+    currentPublished = Clock::now();
+
+    if (threaded) {
+        running = true;
+        thread = std::thread(&Simulation::run, this);
+    }
+}
+
+void Simulation::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    started = false;
+}
+
+void Simulation::step() {
+    assert(started && !threaded && "Only a simulation started without a thread can be stepped");
+    tick(tickInterval);
+    capture(next);
+    publish();
+}
+
+void Simulation::run() {
+    CpuProfiler::setThreadName("simulation");
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(tickInterval));
+    auto nextTick = Clock::now() + interval;
+    while (running) {
+        std::this_thread::sleep_until(nextTick);
+        tick(tickInterval);
+        capture(next);
+        publish();
+
+        nextTick += interval;
+        auto now = Clock::now();
+        if (now - nextTick > interval * MAX_CATCH_UP_TICKS) {
+            nextTick = now;
+        }
+    }
+}
+
+void Simulation::tick(float dt) {
+    PROFILE_SCOPE("simulation tick");
+    time += dt;
+    tickCount.fetch_add(1, std::memory_order_relaxed);
+
+    registry.view<TransformComponent, SpinComponent>().each([&](Entity, TransformComponent& transform, SpinComponent& spin) {
+        if (transform.useOrientation) {
+            glm::quat step = glm::angleAxis(spin.speed * dt, glm::vec3{0.f, 1.f, 0.f});
+            transform.orientation = glm::normalize(step * transform.orientation);
+        } else {
+            transform.rotation.y = glm::mod(transform.rotation.y + spin.speed * dt, glm::two_pi<float>());
+        }
+    });
+    TransformComponent::updateCaches(registry.pool<TransformComponent>().getComponents());
+    sceneGraph.update(registry);
+}
+
+void Simulation::capture(SceneState& state) {
+    PROFILE_SCOPE("capture scene");
+    state.time = time;
+
+    state.objects.clear();
+    registry.view<TransformComponent, ModelComponent>().each([&](Entity entity, TransformComponent& transform, ModelComponent& model) {
+        if (sceneGraph.contains(entity)) {
+            state.objects.push_back({entity, model.model, sceneGraph.worldMatrix(entity), sceneGraph.worldNormalMatrix(entity)});
+        } else {
+            state.objects.push_back({entity, model.model, transform.mat4(), transform.normalMatrix()});
+        }
+    });
+
+    state.lights.clear();
+    registry.view<TransformComponent, PointLightComponent, ColorComponent>().each([&](Entity entity, TransformComponent& transform, PointLightComponent& pointLight, ColorComponent& color) {
+        glm::vec3 position = sceneGraph.contains(entity) ? sceneGraph.worldPosition(entity) : transform.translation;
+        state.lights.push_back({entity, position, color.color, pointLight.lightIntensity, pointLight.radius});
+    });
+}
+
+void Simulation::publish() {
+    std::lock_guard<std::mutex> lock{stateMutex};
+    // the old previous becomes the next back buffer, keeping its capacity
+    std::swap(previous, current);
+    std::swap(current, next);
+    currentPublished = Clock::now();
+}
+
+void Simulation::sample(SceneState& state) {
+    PROFILE_SCOPE("sample scene");
+    std::lock_guard<std::mutex> lock{stateMutex};
+    float alpha = 1.f;
+    if (threaded) {
+        alpha = std::chrono::duration<float>(Clock::now() - currentPublished).count() / tickInterval;
+        alpha = std::clamp(alpha, 0.f, 1.f);
+    }
+
+    state.time = previous.time + (current.time - previous.time) * alpha;
+
+    // views walk pools in packed order, so entries line up unless entities were added or
+    // removed in between. Mismatched entries snap to the current tick.
+    state.objects.resize(current.objects.size());
+    for (size_t i = 0; i < current.objects.size(); i++) {
+        const RenderObject& to = current.objects[i];
+        RenderObject& out = state.objects[i];
+        out = to;
+        if (i < previous.objects.size() && previous.objects[i].entity == to.entity) {
+            const RenderObject& from = previous.objects[i];
+            // a component wise blend slightly shrinks rotating matrices, which is negligible
+            // for the rotation a single tick covers
+            for (int c = 0; c < 4; c++) {
+                out.modelMatrix[c] = from.modelMatrix[c] + (to.modelMatrix[c] - from.modelMatrix[c]) * alpha;
+            }
+            for (int c = 0; c < 3; c++) {
+                out.normalMatrix[c] = from.normalMatrix[c] + (to.normalMatrix[c] - from.normalMatrix[c]) * alpha;
+            }
+        }
+    }
+
+    state.lights.resize(current.lights.size());
+    for (size_t i = 0; i < current.lights.size(); i++) {
+        const RenderLight& to = current.lights[i];
+        RenderLight& out = state.lights[i];
+        out = to;
+        if (i < previous.lights.size() && previous.lights[i].entity == to.entity) {
+            out.position = previous.lights[i].position + (to.position - previous.lights[i].position) * alpha;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Registry.hpp"
+#include "SceneGraph.hpp"
+#include "SceneState.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Advances the scene at a fixed tick rate on its own thread. After every tick the world space
+// state is captured into a back buffer and swapped in, and the render thread samples an
+// interpolation of the last two ticks, so animation speed no longer depends on frame rate.
+// While running, the registry and scene graph belong to the simulation thread.
+class Simulation {
+    public:
+        Simulation(Registry& registry, SceneGraph& sceneGraph, float tickRate);
+        ~Simulation();
+
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+
+        // Without a thread nothing advances on its own, the caller ticks once per step() call.
+        // That keeps fixed timestep runs deterministic.
+        void start(bool threaded = true);
+        void stop();
+        void step();
+
+        // Blends the previous and current tick by the time elapsed since the current one was
+        // published. Rendering therefore runs one tick behind the simulation. When stepped
+        // manually the current tick is returned as is.
+        void sample(SceneState& state);
+
+        float getTickRate() const { return 1.f / tickInterval; }
+        uint64_t getTickCount() const { return tickCount.load(std::memory_order_relaxed); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void run();
+        void tick(float dt);
+        void capture(SceneState& state);
+        void publish();
+
+        Registry& registry;
+        SceneGraph& sceneGraph;
+        float tickInterval;
+        double time{0.0};
+
+        std::thread thread;
+        std::atomic<bool> running{false};
+        bool started{false};
+        bool threaded{true};
+        std::atomic<uint64_t> tickCount{0};
+
+        // next is only touched by the simulation thread, previous and current are guarded
+        std::mutex stateMutex;
+        SceneState previous;
+        SceneState current;
+        SceneState next;
+        Clock::time_point currentPublished{};
+};
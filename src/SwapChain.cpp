@@ -1,7 +1,9 @@
 #include "SwapChain.hpp"
+#include "CpuProfiler.hpp"
 
 // std
 #include <array>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -9,24 +11,49 @@
 #include <set>
 #include <stdexcept>
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, RenderPath renderPath, bool dynamicRendering)
+    : renderPath{renderPath}, dynamicRendering{dynamicRendering}, device{deviceRef}, windowExtent{extent} {
+  assert((!dynamicRendering || renderPath == RenderPath::Forward) && "Dynamic rendering only supports the forward path");
   init();
 }
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+SwapChain::SwapChain(
+    Device &deviceRef,
+    VkExtent2D extent,
+    std::shared_ptr<SwapChain> previous,
+    RenderPath renderPath,
+    bool dynamicRendering)
+    : renderPath{renderPath},
+      dynamicRendering{dynamicRendering},
+      device{deviceRef},
+      windowExtent{extent},
+      oldSwapChain{previous},
+      generation{previous == nullptr ? 1 : previous->generation + 1} {
+  assert((!dynamicRendering || renderPath == RenderPath::Forward) && "Dynamic rendering only supports the forward path");
   init();
 
   oldSwapChain = nullptr;
 }
 
 void SwapChain::init() {
-  createSwapChain();
+  if (device.isHeadless()) {
+    createOffscreenImages();
+  } else {
+    createSwapChain();
+  }
   createImageViews();
-  createRenderPass();
+  if (renderPath == RenderPath::Deferred) {
+    createDeferredRenderPass();
+  } else if (!dynamicRendering) {
+    createRenderPass();
+  }
   createDepthResources();
-  createFramebuffers();
+  if (renderPath == RenderPath::Deferred) {
+    createGBufferResources();
+  }
+  if (!dynamicRendering) {
+    createFramebuffers();
+  }
   createSyncObjects();
 }
 
@@ -41,20 +68,33 @@ SwapChain::~SwapChain() {
     swapChain = nullptr;
   }
 
+  for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+    vkDestroyImage(device.device(), swapChainImages[i], nullptr);
+    device.freeMemory(offscreenImageMemorys[i]);
+  }
+
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.freeMemory(depthImageMemorys[i]);
+  }
+
+  for (size_t i = 0; i < albedoAttachments.size(); i++) {
+    destroyAttachment(albedoAttachments[i]);
+    destroyAttachment(normalAttachments[i]);
+    destroyAttachment(lightingAttachments[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
     vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
   }
 
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  if (renderPass != VK_NULL_HANDLE) {
+    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  }
 
-  // cleanup synchronization objects
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  // cleanup synchronization objects, unless a newer swapchain took them over
+  for (size_t i = 0; i < inFlightFences.size(); i++) {
     vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
     vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
     vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -62,13 +102,24 @@ SwapChain::~SwapChain() {
 }
 
 VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+  {
+    PROFILE_SCOPE("wait for frame fence");
+    vkWaitForFences(
+        device.device(),
+        1,
+        &inFlightFences[currentFrame],
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+  }
 
+  if (device.isHeadless()) {
+    // the fence wait above covers the frame that last rendered into the image
+    *imageIndex = nextOffscreenImage;
+    nextOffscreenImage = (nextOffscreenImage + 1) % imageCount();
+    return VK_SUCCESS;
+  }
+
+  PROFILE_SCOPE("acquire image");
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
       swapChain,
@@ -83,6 +134,7 @@ VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
 VkResult SwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+    PROFILE_SCOPE("wait for image fence");
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
   imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -90,9 +142,12 @@ VkResult SwapChain::submitCommandBuffers(
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+  // headless images are not acquired or presented, so there is nothing to wait on or signal
+  bool headless = device.isHeadless();
+
   VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
   VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.waitSemaphoreCount = headless ? 0 : 1;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
@@ -100,13 +155,21 @@ VkResult SwapChain::submitCommandBuffers(
   submitInfo.pCommandBuffers = buffers;
 
   VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.signalSemaphoreCount = headless ? 0 : 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
   vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
+  {
+    PROFILE_SCOPE("queue submit");
+    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to submit draw command buffer!");
+    }
+  }
+
+  if (headless) {
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return VK_SUCCESS;
   }
 
   VkPresentInfoKHR presentInfo = {};
@@ -121,7 +184,11 @@ VkResult SwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  VkResult result;
+  {
+    PROFILE_SCOPE("present");
+    result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  }
 
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -189,6 +256,39 @@ void SwapChain::createSwapChain() {
   swapChainExtent = extent;
 }
 
+// Stands in for the swapchain when rendering headless. Images rotate like swapchain images and
+// end every frame in TRANSFER_SRC_OPTIMAL so the last one can be read back.
+void SwapChain::createOffscreenImages() {
+  swapChainImageFormat = OFFSCREEN_FORMAT;
+  swapChainExtent = windowExtent;
+  finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+  offscreenImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+  for (size_t i = 0; i < swapChainImages.size(); i++) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = swapChainExtent.width;
+    imageInfo.extent.height = swapChainExtent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = swapChainImageFormat;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    device.createImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        swapChainImages[i],
+        offscreenImageMemorys[i]);
+  }
+}
+
 void SwapChain::createImageViews() {
   swapChainImageViews.resize(swapChainImages.size());
   for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -233,7 +333,7 @@ void SwapChain::createRenderPass() {
   colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  colorAttachment.finalLayout = finalLayout;
 
   VkAttachmentReference colorAttachmentRef = {};
   colorAttachmentRef.attachment = 0;
@@ -271,10 +371,155 @@ void SwapChain::createRenderPass() {
   }
 }
 
+void SwapChain::createDeferredRenderPass() {
+  // 0: swapchain, 1: depth, 2: albedo, 3: normal, 4: hdr lighting accumulation
+  std::array<VkAttachmentDescription, 5> attachments{};
+
+  attachments[0].format = getSwapChainImageFormat();
+  attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  attachments[0].finalLayout = finalLayout;
+
+  attachments[1].format = findDepthFormat();
+  attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+  // the g-buffer never leaves the render pass, so tile based gpus can keep it on chip
+  std::array<VkFormat, 3> transientFormats = {ALBEDO_FORMAT, NORMAL_FORMAT, LIGHTING_FORMAT};
+  for (size_t i = 0; i < transientFormats.size(); i++) {
+    auto &attachment = attachments[i + 2];
+    attachment.format = transientFormats[i];
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  }
+
+  // subpass 0: g-buffer
+  std::array<VkAttachmentReference, 2> gBufferColorRefs = {{
+      {2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+      {3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+  }};
+  VkAttachmentReference gBufferDepthRef = {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+  // subpass 1: lighting, reads the g-buffer and accumulates into the hdr attachment
+  VkAttachmentReference lightingColorRef = {4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  std::array<VkAttachmentReference, 3> lightingInputRefs = {{
+      {2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+      {3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+      {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL},
+  }};
+
+  // subpass 2: composite into the swapchain, depth is kept read only for light billboards
+  VkAttachmentReference compositeColorRef = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  VkAttachmentReference compositeInputRef = {4, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  VkAttachmentReference compositeDepthRef = {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+
+  std::array<VkSubpassDescription, 3> subpasses{};
+  subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpasses[0].colorAttachmentCount = static_cast<uint32_t>(gBufferColorRefs.size());
+  subpasses[0].pColorAttachments = gBufferColorRefs.data();
+  subpasses[0].pDepthStencilAttachment = &gBufferDepthRef;
+
+  subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpasses[1].colorAttachmentCount = 1;
+  subpasses[1].pColorAttachments = &lightingColorRef;
+  subpasses[1].inputAttachmentCount = static_cast<uint32_t>(lightingInputRefs.size());
+  subpasses[1].pInputAttachments = lightingInputRefs.data();
+
+  subpasses[2].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpasses[2].colorAttachmentCount = 1;
+  subpasses[2].pColorAttachments = &compositeColorRef;
+  subpasses[2].inputAttachmentCount = 1;
+  subpasses[2].pInputAttachments = &compositeInputRef;
+  subpasses[2].pDepthStencilAttachment = &compositeDepthRef;
+
+  std::array<VkSubpassDependency, 5> dependencies{};
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = 0;
+  dependencies[0].dstStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].dstAccessMask =
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = 1;
+  dependencies[1].srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[1].srcAccessMask =
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+  dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+  dependencies[2].srcSubpass = 1;
+  dependencies[2].dstSubpass = 2;
+  dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependencies[2].dstStageMask =
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[2].dstAccessMask =
+      VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+  dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+  // the composite subpass depth tests against the g-buffer depth, 0 -> 1 -> 2 doesn't chain that
+  dependencies[3].srcSubpass = 0;
+  dependencies[3].dstSubpass = 2;
+  dependencies[3].srcStageMask =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[3].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[3].dstStageMask =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[3].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+  dependencies[3].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+  // the swapchain image is first written by the composite subpass, so its clear and layout
+  // transition have to wait for the acquire semaphore, which is waited on at color output
+  dependencies[4].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[4].dstSubpass = 2;
+  dependencies[4].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[4].srcAccessMask = 0;
+  dependencies[4].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[4].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo = {};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  renderPassInfo.pAttachments = attachments.data();
+  renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+  renderPassInfo.pSubpasses = subpasses.data();
+  renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+  renderPassInfo.pDependencies = dependencies.data();
+
+  if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create deferred render pass!");
+  }
+}
+
 void SwapChain::createFramebuffers() {
   swapChainFramebuffers.resize(imageCount());
   for (size_t i = 0; i < imageCount(); i++) {
-    std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
+    std::vector<VkImageView> attachments = {swapChainImageViews[i], depthImageViews[i]};
+    if (renderPath == RenderPath::Deferred) {
+      attachments.push_back(albedoAttachments[i].view);
+      attachments.push_back(normalAttachments[i].view);
+      attachments.push_back(lightingAttachments[i].view);
+    }
 
     VkExtent2D swapChainExtent = getSwapChainExtent();
     VkFramebufferCreateInfo framebufferInfo = {};
@@ -318,6 +563,9 @@ void SwapChain::createDepthResources() {
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (renderPath == RenderPath::Deferred) {
+      imageInfo.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+    }
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.flags = 0;
@@ -345,11 +593,97 @@ void SwapChain::createDepthResources() {
   }
 }
 
+void SwapChain::createGBufferResources() {
+  VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                            VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                            VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+  albedoAttachments.resize(imageCount());
+  normalAttachments.resize(imageCount());
+  lightingAttachments.resize(imageCount());
+  for (size_t i = 0; i < imageCount(); i++) {
+    albedoAttachments[i] = createAttachment(ALBEDO_FORMAT, usage);
+    normalAttachments[i] = createAttachment(NORMAL_FORMAT, usage);
+    lightingAttachments[i] = createAttachment(LIGHTING_FORMAT, usage);
+  }
+}
+
+SwapChain::Attachment SwapChain::createAttachment(VkFormat format, VkImageUsageFlags usage) {
+  Attachment attachment{};
+  VkExtent2D swapChainExtent = getSwapChainExtent();
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = swapChainExtent.width;
+  imageInfo.extent.height = swapChainExtent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = format;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = usage;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.flags = 0;
+
+  VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  if ((usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) && device.supportsLazilyAllocatedMemory()) {
+    memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+  }
+  device.createImageWithInfo(imageInfo, memoryProperties, attachment.image, attachment.memory);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = attachment.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = format;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+
+  if (vkCreateImageView(device.device(), &viewInfo, nullptr, &attachment.view) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create g-buffer image view!");
+  }
+  return attachment;
+}
+
+void SwapChain::destroyAttachment(Attachment &attachment) {
+  vkDestroyImageView(device.device(), attachment.view, nullptr);
+  vkDestroyImage(device.device(), attachment.image, nullptr);
+  device.freeMemory(attachment.memory);
+}
+
+GBufferViews SwapChain::getGBufferViews(int index) {
+  assert(renderPath == RenderPath::Deferred && "G-buffer only exists on the deferred render path");
+  return GBufferViews{
+      albedoAttachments[index].view,
+      normalAttachments[index].view,
+      depthImageViews[index],
+      lightingAttachments[index].view,
+      generation,
+      static_cast<uint32_t>(index)};
+}
+
 void SwapChain::createSyncObjects() {
+  imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+
+  // frames submitted against the old swapchain still signal its fences and semaphores, so they
+  // carry over and waiting on a frame slot keeps covering the work in flight
+  if (oldSwapChain != nullptr) {
+    imageAvailableSemaphores.swap(oldSwapChain->imageAvailableSemaphores);
+    renderFinishedSemaphores.swap(oldSwapChain->renderFinishedSemaphores);
+    inFlightFences.swap(oldSwapChain->inFlightFences);
+    currentFrame = oldSwapChain->currentFrame;
+    return;
+  }
+
   imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
   renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
   inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-  imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
   VkSemaphoreCreateInfo semaphoreInfo = {};
   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
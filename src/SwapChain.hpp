@@ -10,12 +10,50 @@
 #include <string>
 #include <vector>
 
+enum class RenderPath {
+  Forward,
+  // G-buffer, lighting and composite subpasses in a single render pass
+  Deferred
+};
+
+// What pipelines drawing into the swapchain are built against. With dynamic rendering there is
+// no render pass, pipelines only name the attachment formats.
+struct RenderTarget {
+  VkRenderPass renderPass = VK_NULL_HANDLE;
+  VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+  VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+};
+
+// Per-image attachments read as input attachments by the deferred lighting subpasses
+struct GBufferViews {
+  VkImageView albedo;
+  VkImageView normal;
+  VkImageView depth;
+  VkImageView lighting;
+  // which swapchain and image the views belong to, view handles may be reused after a recreate
+  uint32_t generation;
+  uint32_t imageIndex;
+};
+
 class SwapChain {
  public:
   static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent);
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+  // Passing previous retires it. The new swapchain takes over its per-frame fences and
+  // semaphores, previous must stay alive until the frames recorded against it completed.
+  // dynamicRendering skips the render pass and framebuffers, so recreating on resize only
+  // rebuilds images. Only the forward path supports it.
+  SwapChain(
+      Device &deviceRef,
+      VkExtent2D windowExtent,
+      RenderPath renderPath = RenderPath::Forward,
+      bool dynamicRendering = false);
+  SwapChain(
+      Device &deviceRef,
+      VkExtent2D windowExtent,
+      std::shared_ptr<SwapChain> previous,
+      RenderPath renderPath = RenderPath::Forward,
+      bool dynamicRendering = false);
   ~SwapChain();
 
   SwapChain(const SwapChain &) = delete;
@@ -24,6 +62,19 @@ class SwapChain {
   VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
   VkRenderPass getRenderPass() { return renderPass; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  VkImage getImage(int index) { return swapChainImages[index]; }
+  VkImage getDepthImage(int index) { return depthImages[index]; }
+  VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+  RenderTarget getRenderTarget() { return {renderPass, swapChainImageFormat, swapChainDepthFormat}; }
+  bool usesDynamicRendering() const { return dynamicRendering; }
+  // Layout the color image is left in at the end of a frame, ready to present or, headless,
+  // to be copied out
+  VkImageLayout getFinalLayout() const { return finalLayout; }
+  GBufferViews getGBufferViews(int index);
+  RenderPath getRenderPath() const { return renderPath; }
+  // counts up with every recreate, starting at 1
+  uint32_t getGeneration() const { return generation; }
+  uint32_t attachmentCount() const { return renderPath == RenderPath::Deferred ? 5 : 2; }
   size_t imageCount() { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -46,9 +97,12 @@ class SwapChain {
  private:
   void init();
   void createSwapChain();
+  void createOffscreenImages();
   void createImageViews();
   void createDepthResources();
   void createRenderPass();
+  void createDeferredRenderPass();
+  void createGBufferResources();
   void createFramebuffers();
   void createSyncObjects();
 
@@ -59,24 +113,50 @@ class SwapChain {
       const std::vector<VkPresentModeKHR> &availablePresentModes);
   VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
+  struct Attachment {
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view;
+  };
+  Attachment createAttachment(VkFormat format, VkImageUsageFlags usage);
+  void destroyAttachment(Attachment &attachment);
+
+  static constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+  static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+  static constexpr VkFormat LIGHTING_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+  // required to support color attachment and transfer use, and maps straight to RGB files
+  static constexpr VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+  RenderPath renderPath;
+  bool dynamicRendering;
+
   VkFormat swapChainImageFormat;
   VkFormat swapChainDepthFormat;
   VkExtent2D swapChainExtent;
 
   std::vector<VkFramebuffer> swapChainFramebuffers;
-  VkRenderPass renderPass;
+  VkRenderPass renderPass = VK_NULL_HANDLE;
 
   std::vector<VkImage> depthImages;
   std::vector<VkDeviceMemory> depthImageMemorys;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
+  // headless only, swapChainImages are plain images backed by these
+  std::vector<VkDeviceMemory> offscreenImageMemorys;
+  uint32_t nextOffscreenImage = 0;
+  VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+  std::vector<Attachment> albedoAttachments;
+  std::vector<Attachment> normalAttachments;
+  std::vector<Attachment> lightingAttachments;
 
   Device &device;
   VkExtent2D windowExtent;
 
-  VkSwapchainKHR swapChain;
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
   std::shared_ptr<SwapChain> oldSwapChain;
+  uint32_t generation;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
@@ -0,0 +1,339 @@
+#include "TransformBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// TRANSFORM_BATCH_NO_SIMD builds the portable kernel, so it can be checked on any machine
+#if defined(TRANSFORM_BATCH_NO_SIMD)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define TRANSFORM_BATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFORM_BATCH_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TRANSFORM_BATCH_NEON
+#endif
+
+// Every instruction set exposes the same handful of float operations, so the kernels below
+// are written once. Only float ops are used since AVX1 has no 256 bit integer instructions.
+namespace {
+
+#if defined(TRANSFORM_BATCH_AVX)
+using vfloat = __m256;
+constexpr size_t WIDTH = 8;
+inline vfloat load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, vfloat v) { _mm256_storeu_ps(p, v); }
+inline vfloat set1(float f) { return _mm256_set1_ps(f); }
+inline vfloat add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat maskOr(vfloat a, vfloat b) { return _mm256_or_ps(a, b); }
+inline vfloat cmpEq(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline vfloat cmpGe(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+// and/andnot rather than blendv, gcc rewrites blendv as an integer sign test that AVX1 has to scalarize
+inline vfloat select(vfloat mask, vfloat a, vfloat b) { return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b)); }
+inline vfloat truncate(vfloat a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+// Writes lane l of rows[0..count) to dst[l][0..count), a 4x4 transpose per 128 bit half
+inline void storeLanes(vfloat rows[4], float* const* dst, size_t lanes, int count) {
+    for (int half = 0; half < 2 && half * 4 < static_cast<int>(lanes); half++) {
+        __m128 r[4];
+        for (int k = 0; k < 4; k++) {
+            r[k] = half == 0 ? _mm256_castps256_ps128(rows[k]) : _mm256_extractf128_ps(rows[k], 1);
+        }
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+        for (size_t lane = half * 4; lane < lanes && lane < static_cast<size_t>(half * 4 + 4); lane++) {
+            if (count == 4) {
+                _mm_storeu_ps(dst[lane], r[lane - half * 4]);
+            } else {
+                alignas(16) float column[4];
+                _mm_store_ps(column, r[lane - half * 4]);
+                std::copy(column, column + count, dst[lane]);
+            }
+        }
+    }
+}
+#elif defined(TRANSFORM_BATCH_SSE)
+using vfloat = __m128;
+constexpr size_t WIDTH = 4;
+inline vfloat load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, vfloat v) { _mm_storeu_ps(p, v); }
+inline vfloat set1(float f) { return _mm_set1_ps(f); }
+inline vfloat add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat maskOr(vfloat a, vfloat b) { return _mm_or_ps(a, b); }
+inline vfloat cmpEq(vfloat a, vfloat b) { return _mm_cmpeq_ps(a, b); }
+inline vfloat cmpGe(vfloat a, vfloat b) { return _mm_cmpge_ps(a, b); }
+inline vfloat select(vfloat mask, vfloat a, vfloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+// only used on non negative values below 2^31
+inline vfloat truncate(vfloat a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+// Writes lane l of rows[0..count) to dst[l][0..count) through a 4x4 transpose
+inline void storeLanes(vfloat rows[4], float* const* dst, size_t lanes, int count) {
+    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+    for (size_t lane = 0; lane < lanes; lane++) {
+        if (count == 4) {
+            _mm_storeu_ps(dst[lane], rows[lane]);
+        } else {
+            alignas(16) float column[4];
+            _mm_store_ps(column, rows[lane]);
+            std::copy(column, column + count, dst[lane]);
+        }
+    }
+}
+#elif defined(TRANSFORM_BATCH_NEON)
+using vfloat = float32x4_t;
+constexpr size_t WIDTH = 4;
+inline vfloat load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, vfloat v) { vst1q_f32(p, v); }
+inline vfloat set1(float f) { return vdupq_n_f32(f); }
+inline vfloat add(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+inline vfloat div(vfloat a, vfloat b) {
+    // two newton steps on the reciprocal estimate, armv7 has no vector divide
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+inline vfloat maskOr(vfloat a, vfloat b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+inline vfloat cmpEq(vfloat a, vfloat b) { return vreinterpretq_f32_u32(vceqq_f32(a, b)); }
+inline vfloat cmpGe(vfloat a, vfloat b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+inline vfloat select(vfloat mask, vfloat a, vfloat b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+inline vfloat truncate(vfloat a) { return vcvtq_f32_s32(vcvtq_s32_f32(a)); }
+// Writes lane l of rows[0..count) to dst[l][0..count) through a 4x4 transpose
+inline void storeLanes(vfloat rows[4], float* const* dst, size_t lanes, int count) {
+    float32x4x2_t t01 = vtrnq_f32(rows[0], rows[1]);
+    float32x4x2_t t23 = vtrnq_f32(rows[2], rows[3]);
+    float32x4_t columns[4] = {
+        vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])),
+        vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])),
+        vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])),
+        vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])),
+    };
+    for (size_t lane = 0; lane < lanes; lane++) {
+        if (count == 4) {
+            vst1q_f32(dst[lane], columns[lane]);
+        } else {
+            float column[4];
+            vst1q_f32(column, columns[lane]);
+            std::copy(column, column + count, dst[lane]);
+        }
+    }
+}
+#else
+using vfloat = float;
+constexpr size_t WIDTH = 1;
+inline vfloat load(const float* p) { return *p; }
+inline void store(float* p, vfloat v) { *p = v; }
+inline vfloat set1(float f) { return f; }
+inline vfloat add(vfloat a, vfloat b) { return a + b; }
+inline vfloat sub(vfloat a, vfloat b) { return a - b; }
+inline vfloat mul(vfloat a, vfloat b) { return a * b; }
+inline vfloat div(vfloat a, vfloat b) { return a / b; }
+inline vfloat select(bool mask, vfloat a, vfloat b) { return mask ? a : b; }
+inline bool maskOr(bool a, bool b) { return a || b; }
+inline bool cmpEq(vfloat a, vfloat b) { return a == b; }
+inline bool cmpGe(vfloat a, vfloat b) { return a >= b; }
+inline vfloat truncate(vfloat a) { return std::trunc(a); }
+inline void storeLanes(vfloat rows[4], float* const* dst, size_t lanes, int count) {
+    std::copy(rows, rows + count, dst[0]);
+}
+#endif
+
+inline vfloat negate(vfloat a) { return sub(set1(0.f), a); }
+inline vfloat absolute(vfloat a) { return select(cmpGe(a, set1(0.f)), a, negate(a)); }
+
+// Cephes sinf/cosf: reduce to an octant of [0, pi/4] in extended precision, evaluate both
+// minimax polynomials and pick per lane. The octant bookkeeping is done on whole floats.
+inline void sinCosV(vfloat x, vfloat& s, vfloat& c) {
+    auto negativeInput = cmpGe(set1(0.f), x);
+    x = absolute(x);
+
+    // j = (int(x * 4 / pi) + 1) & ~1
+    vfloat j = truncate(mul(x, set1(1.27323954473516f)));
+    j = mul(truncate(mul(add(j, set1(1.f)), set1(0.5f))), set1(2.f));
+    vfloat octant = sub(j, mul(truncate(mul(j, set1(0.125f))), set1(8.f)));
+
+    x = sub(x, mul(j, set1(0.78515625f)));
+    x = sub(x, mul(j, set1(2.4187564849853515625e-4f)));
+    x = sub(x, mul(j, set1(3.77489497744594108e-8f)));
+
+    vfloat z = mul(x, x);
+    vfloat cosPoly = set1(2.443315711809948e-5f);
+    cosPoly = add(mul(cosPoly, z), set1(-1.388731625493765e-3f));
+    cosPoly = add(mul(cosPoly, z), set1(4.166664568298827e-2f));
+    cosPoly = mul(mul(cosPoly, z), z);
+    cosPoly = add(sub(cosPoly, mul(z, set1(0.5f))), set1(1.f));
+
+    vfloat sinPoly = set1(-1.9515295891e-4f);
+    sinPoly = add(mul(sinPoly, z), set1(8.3321608736e-3f));
+    sinPoly = add(mul(sinPoly, z), set1(-1.6666654611e-1f));
+    sinPoly = add(mul(mul(sinPoly, z), x), x);
+
+    // octants 2 and 6 swap the polynomials, sin flips in 4 and 6, cos flips in 2 and 4
+    auto octant2 = cmpEq(octant, set1(2.f));
+    auto swap = maskOr(octant2, cmpEq(octant, set1(6.f)));
+    s = select(swap, cosPoly, sinPoly);
+    c = select(swap, sinPoly, cosPoly);
+    s = select(cmpGe(octant, set1(4.f)), negate(s), s);
+    c = select(maskOr(octant2, cmpEq(octant, set1(4.f))), negate(c), c);
+
+    // sin is odd, cos is even
+    s = select(negativeInput, negate(s), s);
+}
+
+// Builds WIDTH transforms and writes the first lanes of them straight into the matrices
+inline void computeBlock(const float* const in[9], size_t lanes, glm::mat4* modelMatrices, glm::mat3* normalMatrices) {
+    vfloat sx, cx, sy, cy, sz, cz;
+    sinCosV(load(in[3]), sx, cx);
+    sinCosV(load(in[4]), sy, cy);
+    sinCosV(load(in[5]), sz, cz);
+    // naming follows TransformComponent::mat4, 1 = y, 2 = x, 3 = z
+    const vfloat c1 = cy, s1 = sy, c2 = cx, s2 = sx, c3 = cz, s3 = sz;
+
+    const vfloat rotation[3][3] = {
+        {add(mul(c1, c3), mul(mul(s1, s2), s3)), mul(c2, s3), sub(mul(mul(c1, s2), s3), mul(c3, s1))},
+        {sub(mul(mul(c3, s1), s2), mul(c1, s3)), mul(c2, c3), add(mul(mul(c1, c3), s2), mul(s1, s3))},
+        {mul(c2, s1), negate(s2), mul(c1, c2)},
+    };
+
+    const vfloat zero = set1(0.f);
+    const vfloat one = set1(1.f);
+    float* modelColumns[WIDTH];
+    float* normalColumns[WIDTH];
+    for (int column = 0; column < 3; column++) {
+        vfloat scale = load(in[6 + column]);
+        vfloat invScale = div(one, scale);
+        for (size_t lane = 0; lane < lanes; lane++) {
+            modelColumns[lane] = &modelMatrices[lane][column][0];
+            normalColumns[lane] = &normalMatrices[lane][column][0];
+        }
+        vfloat model[4] = {mul(scale, rotation[column][0]), mul(scale, rotation[column][1]), mul(scale, rotation[column][2]), zero};
+        storeLanes(model, modelColumns, lanes, 4);
+        // a 4 wide store spills into the next column, which is written afterwards; the last column can't
+        vfloat normal[4] = {mul(invScale, rotation[column][0]), mul(invScale, rotation[column][1]), mul(invScale, rotation[column][2]), zero};
+        storeLanes(normal, normalColumns, lanes, column < 2 ? 4 : 3);
+    }
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        modelColumns[lane] = &modelMatrices[lane][3][0];
+    }
+    vfloat translation[4] = {load(in[0]), load(in[1]), load(in[2]), one};
+    storeLanes(translation, modelColumns, lanes, 4);
+}
+
+}
+
+void TransformBatch::resize(size_t count) {
+    for (auto* array : {&translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ}) {
+        array->resize(count, 0.f);
+    }
+    for (auto* array : {&scaleX, &scaleY, &scaleZ}) {
+        array->resize(count, 1.f);
+    }
+}
+
+void TransformBatch::set(size_t index, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale) {
+    translationX[index] = translation.x;
+    translationY[index] = translation.y;
+    translationZ[index] = translation.z;
+    rotationX[index] = rotation.x;
+    rotationY[index] = rotation.y;
+    rotationZ[index] = rotation.z;
+    scaleX[index] = scale.x;
+    scaleY[index] = scale.y;
+    scaleZ[index] = scale.z;
+}
+
+void computeTransforms(const TransformBatch& batch, glm::mat4* modelMatrices, glm::mat3* normalMatrices) {
+    const float* arrays[9] = {
+        batch.translationX.data(), batch.translationY.data(), batch.translationZ.data(),
+        batch.rotationX.data(), batch.rotationY.data(), batch.rotationZ.data(),
+        batch.scaleX.data(), batch.scaleY.data(), batch.scaleZ.data(),
+    };
+
+    size_t count = batch.size();
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        const float* in[9];
+        for (int a = 0; a < 9; a++) {
+            in[a] = arrays[a] + i;
+        }
+        computeBlock(in, WIDTH, modelMatrices + i, normalMatrices + i);
+    }
+
+    // tail goes through the same kernel with padded inputs
+    if (i < count) {
+        float padded[9][WIDTH];
+        const float* in[9];
+        for (int a = 0; a < 9; a++) {
+            std::fill(padded[a], padded[a] + WIDTH, a >= 6 ? 1.f : 0.f);
+            std::copy(arrays[a] + i, arrays[a] + count, padded[a]);
+            in[a] = padded[a];
+        }
+        computeBlock(in, count - i, modelMatrices + i, normalMatrices + i);
+    }
+}
+
+void computeTransformsScalar(const TransformBatch& batch, glm::mat4* modelMatrices, glm::mat3* normalMatrices) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        const float c3 = std::cos(batch.rotationZ[i]);
+        const float s3 = std::sin(batch.rotationZ[i]);
+        const float c2 = std::cos(batch.rotationX[i]);
+        const float s2 = std::sin(batch.rotationX[i]);
+        const float c1 = std::cos(batch.rotationY[i]);
+        const float s1 = std::sin(batch.rotationY[i]);
+        const glm::vec3 scale{batch.scaleX[i], batch.scaleY[i], batch.scaleZ[i]};
+        const glm::vec3 invScale = 1.0f / scale;
+        const glm::mat3 rotation{
+            {c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1},
+            {c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3},
+            {c2 * s1, -s2, c1 * c2},
+        };
+        modelMatrices[i] = glm::mat4{
+            glm::vec4(scale.x * rotation[0], 0.f),
+            glm::vec4(scale.y * rotation[1], 0.f),
+            glm::vec4(scale.z * rotation[2], 0.f),
+            glm::vec4(batch.translationX[i], batch.translationY[i], batch.translationZ[i], 1.f),
+        };
+        normalMatrices[i] = glm::mat3{invScale.x * rotation[0], invScale.y * rotation[1], invScale.z * rotation[2]};
+    }
+}
+
+void sinCos(const float* x, float* sinOut, float* cosOut, size_t count) {
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        vfloat s, c;
+        sinCosV(load(x + i), s, c);
+        store(sinOut + i, s);
+        store(cosOut + i, c);
+    }
+    for (; i < count; i++) {
+        float padded[WIDTH] = {};
+        float s[WIDTH], c[WIDTH];
+        padded[0] = x[i];
+        vfloat vs, vc;
+        sinCosV(load(padded), vs, vc);
+        store(s, vs);
+        store(c, vc);
+        sinOut[i] = s[0];
+        cosOut[i] = c[0];
+    }
+}
+
+const char* transformBatchIsa() {
+#if defined(TRANSFORM_BATCH_AVX)
+    return "avx";
+#elif defined(TRANSFORM_BATCH_SSE)
+    return "sse2";
+#elif defined(TRANSFORM_BATCH_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Structure of arrays input for building many transform matrices at once
+struct TransformBatch {
+    std::vector<float> translationX, translationY, translationZ;
+    std::vector<float> rotationX, rotationY, rotationZ;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    void resize(size_t count);
+    void set(size_t index, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+    size_t size() const { return translationX.size(); }
+};
+
+// Builds Translate * Ry * Rx * Rz * Scale and its normal matrix for every entry, matching
+// TransformComponent::mat4 and normalMatrix. Uses AVX, SSE2 or NEON when compiled in.
+void computeTransforms(const TransformBatch& batch, glm::mat4* modelMatrices, glm::mat3* normalMatrices);
+// Scalar reference built on std::sin and std::cos
+void computeTransformsScalar(const TransformBatch& batch, glm::mat4* modelMatrices, glm::mat3* normalMatrices);
+
+// Vectorized Cephes style sincos, accurate to a few ulp for |x| below 8192
+void sinCos(const float* x, float* sinOut, float* cosOut, size_t count);
+
+// Name of the instruction set computeTransforms was compiled for
+const char* transformBatchIsa();
@@ -0,0 +1,41 @@
+#include "UniformRing.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+UniformRing::UniformRing(Device& device, VkDeviceSize bytesPerFrame)
+    : alignment{device.properties.limits.minUniformBufferOffsetAlignment} {
+    // frame regions start aligned too, so every offset handed out is
+    this->bytesPerFrame = (bytesPerFrame + alignment - 1) & ~(alignment - 1);
+    buffer = std::make_unique<Buffer>(
+        device,
+        this->bytesPerFrame,
+        SwapChain::MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        alignment);
+    if (buffer->map() != VK_SUCCESS) {
+        throw std::runtime_error("Failed to map uniform ring");
+    }
+    mapped = static_cast<uint8_t*>(buffer->getMappedMemory());
+}
+
+void UniformRing::beginFrame(int frameIndex) {
+    assert(frameIndex >= 0 && frameIndex < SwapChain::MAX_FRAMES_IN_FLIGHT && "Frame index out of range");
+    frameStart = bytesPerFrame * frameIndex;
+    cursor = frameStart;
+}
+
+UniformRing::Allocation UniformRing::allocate(VkDeviceSize size) {
+    VkDeviceSize alignedSize = (size + alignment - 1) & ~(alignment - 1);
+    if (cursor + alignedSize > frameStart + bytesPerFrame) {
+        throw std::runtime_error("Uniform ring ran out of space for this frame");
+    }
+    Allocation allocation{mapped + cursor, static_cast<uint32_t>(cursor)};
+    cursor += alignedSize;
+    return allocation;
+}
+
+VkDescriptorBufferInfo UniformRing::descriptorInfo(VkDeviceSize range) const {
+    return VkDescriptorBufferInfo{buffer->getBuffer(), 0, range};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Per frame uniform data in one persistently mapped, host coherent buffer with a region per
+// frame in flight. Allocations bump a cursor through the current frame's region, aligned to
+// minUniformBufferOffsetAlignment, and are bound through UNIFORM_BUFFER_DYNAMIC descriptors
+// with the returned offset. A descriptor written once per binding serves every frame and draw,
+// and nothing is allocated or flushed while rendering.
+class UniformRing {
+    public:
+        struct Allocation {
+            void* data;
+            uint32_t offset; // dynamic offset to bind with
+        };
+
+        UniformRing(Device& device, VkDeviceSize bytesPerFrame);
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        // Starts allocating from frameIndex's region, whose previous contents the gpu is done
+        // with once the frame's fence has signaled, i.e. after Renderer::beginFrame
+        void beginFrame(int frameIndex);
+
+        Allocation allocate(VkDeviceSize size);
+
+        // Copies value into the current frame and returns its dynamic offset
+        template<typename T>
+        uint32_t push(const T& value) {
+            Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation.offset;
+        }
+
+        // range is the size of the block the shader reads at each dynamic offset
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const;
+
+        VkDeviceSize getAlignment() const { return alignment; }
+        VkDeviceSize getBytesPerFrame() const { return bytesPerFrame; }
+        // bytes allocated so far in the current frame
+        VkDeviceSize getFrameUsage() const { return cursor - frameStart; }
+
+    private:
+        VkDeviceSize alignment;
+        VkDeviceSize bytesPerFrame;
+        std::unique_ptr<Buffer> buffer;
+        uint8_t* mapped{nullptr};
+
+        VkDeviceSize frameStart{0};
+        VkDeviceSize cursor{0};
+};
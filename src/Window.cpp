@@ -1,13 +1,17 @@
 #include "Window.hpp"
 #include <stdexcept>
 
-Window::Window(int w, int h, std::string name) : width{w}, height{h}, windowName{name} {
-    initWindow();
+Window::Window(int w, int h, std::string name, bool headless) : width{w}, height{h}, headless{headless}, windowName{name} {
+    if (!headless) {
+        initWindow();
+    }
 }
 
 Window::~Window() {
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (!headless) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 void Window::initWindow() {
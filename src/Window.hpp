@@ -10,17 +10,20 @@ class Window {
         int width;
         int height;
         bool framebufferResized = false;
+        bool headless;
 
         std::string windowName;
-        GLFWwindow* window;
+        GLFWwindow* window = nullptr;
     public:
-        Window(int w, int h, std::string name);
+        // A headless window never touches GLFW, it only fixes the extent of offscreen rendering
+        Window(int w, int h, std::string name, bool headless = false);
         ~Window();
 
         Window(const Window&) = delete;
         Window &operator=(const Window &) = delete;
 
-        bool shouldClose() {return glfwWindowShouldClose(window);} 
+        bool isHeadless() const { return headless; }
+        bool shouldClose() {return !headless && glfwWindowShouldClose(window);}
         VkExtent2D getExtent() {return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};}
         bool wasWindowResized() {return framebufferResized;}
         void resetWindowResizedFlag() {framebufferResized = false;}
@@ -3,11 +3,14 @@
 #include <iostream>
 #include <stdexcept>
 
-int main() {
-    App app;
-
+int main(int argc, char** argv) {
     try {
+        // bad arguments and a replay that does not fit the settings are reported like any other error
+        App app{Settings::fromArgs(argc, argv)};
         app.run();
+        if (app.replayMismatched()) {
+            return EXIT_FAILURE;
+        }
     } catch (const std::exception &e) {
         std::cerr << e.what() << '\n';
         return EXIT_FAILURE;
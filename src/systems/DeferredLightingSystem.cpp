@@ -0,0 +1,162 @@
+#include "DeferredLightingSystem.hpp"
+#include "../GpuProfiler.hpp"
+#include "../FrameCapture.hpp"
+#include <stdexcept>
+#include <cassert>
+#include <array>
+
+DeferredLightingSystem::DeferredLightingSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device} {
+    createDescriptors();
+    createPipelineLayout(globalSetLayout);
+    createPipelines(renderPass);
+}
+
+DeferredLightingSystem::~DeferredLightingSystem() {
+    vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+}
+
+void DeferredLightingSystem::createDescriptors() {
+    gBufferSetLayout = DescriptorSetLayout::Builder(device)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .addBinding(2, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .addBinding(3, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .build();
+
+    gBufferPool = DescriptorPool::Builder(device)
+        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 4 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .build();
+
+    // one set per frame in flight, rewritten whenever the frame lands on a different swapchain
+    // image or the swapchain has been recreated
+    gBufferDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    writtenViews.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, GBufferViews{});
+    for (auto& set : gBufferDescriptorSets) {
+        if (!gBufferPool->allocateDescriptor(gBufferSetLayout->getDescriptorSetLayout(), set)) {
+            throw std::runtime_error("Failed to allocate g-buffer descriptor set");
+        }
+    }
+}
+
+void DeferredLightingSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, gBufferSetLayout->getDescriptorSetLayout()};
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    if(vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipelineLayout");
+    }
+}
+
+void DeferredLightingSystem::createPipelines(VkRenderPass renderPass) {
+    assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+    PipelineConfigInfo pipelineConfig{};
+    Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+    pipelineConfig.attributeDescriptions.clear();
+    pipelineConfig.bindingDescriptions.clear();
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+    pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+    pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+
+    pipelineConfig.subpass = 1;
+    ambientPipeline = std::make_unique<Pipeline>(
+        device,
+        "../shaders/compiled_shaders/fullscreen.vert.spv",
+        "../shaders/compiled_shaders/deferred_ambient.frag.spv",
+        pipelineConfig);
+
+    // light volumes accumulate on top of the ambient term
+    pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+    pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipelineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipelineConfig.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    // alpha marks covered pixels and is only written by the ambient pass
+    pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipelineConfig.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    lightVolumePipeline = std::make_unique<Pipeline>(
+        device,
+        "../shaders/compiled_shaders/light_volume.vert.spv",
+        "../shaders/compiled_shaders/light_volume.frag.spv",
+        pipelineConfig);
+
+    pipelineConfig.colorBlendAttachment.blendEnable = VK_FALSE;
+    pipelineConfig.subpass = 2;
+    compositePipeline = std::make_unique<Pipeline>(
+        device,
+        "../shaders/compiled_shaders/fullscreen.vert.spv",
+        "../shaders/compiled_shaders/deferred_composite.frag.spv",
+        pipelineConfig);
+}
+
+// handles are not compared, a recreated swapchain may hand out the same ones for new images
+static bool sameViews(const GBufferViews& a, const GBufferViews& b) {
+    return a.generation == b.generation && a.imageIndex == b.imageIndex;
+}
+
+void DeferredLightingSystem::bindDescriptorSets(FrameInfo& frameInfo) {
+    std::array<VkDescriptorSet, 2> sets{frameInfo.globalDescriptorSet, gBufferDescriptorSets[frameInfo.frameIndex]};
+    vkCmdBindDescriptorSets(
+        frameInfo.commandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        pipelineLayout,
+        0,
+        static_cast<uint32_t>(sets.size()),
+        sets.data(),
+        1,
+        &frameInfo.globalUboOffset);
+}
+
+void DeferredLightingSystem::renderLighting(FrameInfo& frameInfo, const GBufferViews& gBuffer, int numLights) {
+    GpuProfiler::Scope scope{frameInfo.profiler, frameInfo.commandBuffer, "deferred lighting", true};
+    // the frame's fence has been waited on, so its set is no longer in use by the gpu
+    if (!sameViews(writtenViews[frameInfo.frameIndex], gBuffer)) {
+        VkDescriptorImageInfo albedoInfo{VK_NULL_HANDLE, gBuffer.albedo, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        VkDescriptorImageInfo normalInfo{VK_NULL_HANDLE, gBuffer.normal, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        VkDescriptorImageInfo depthInfo{VK_NULL_HANDLE, gBuffer.depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+        VkDescriptorImageInfo lightingInfo{VK_NULL_HANDLE, gBuffer.lighting, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        DescriptorWriter(*gBufferSetLayout, *gBufferPool)
+            .writeImage(0, &albedoInfo)
+            .writeImage(1, &normalInfo)
+            .writeImage(2, &depthInfo)
+            .writeImage(3, &lightingInfo)
+            .overwrite(gBufferDescriptorSets[frameInfo.frameIndex]);
+        writtenViews[frameInfo.frameIndex] = gBuffer;
+    }
+
+    ambientPipeline->bind(frameInfo.commandBuffer);
+    bindDescriptorSets(frameInfo);
+    vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+    if (frameInfo.drawStream) {
+        frameInfo.drawStream->bindPipeline("deferred ambient");
+        frameInfo.drawStream->bindDescriptorSets(0, 2);
+        frameInfo.drawStream->draw(3, 1);
+    }
+
+    if (numLights > 0) {
+        lightVolumePipeline->bind(frameInfo.commandBuffer);
+        vkCmdDraw(frameInfo.commandBuffer, 6, static_cast<uint32_t>(numLights), 0, 0);
+        if (frameInfo.drawStream) {
+            frameInfo.drawStream->bindPipeline("deferred light volumes");
+            frameInfo.drawStream->draw(6, static_cast<uint32_t>(numLights));
+        }
+    }
+}
+
+void DeferredLightingSystem::renderComposite(FrameInfo& frameInfo) {
+    GpuProfiler::Scope scope{frameInfo.profiler, frameInfo.commandBuffer, "composite", true};
+    compositePipeline->bind(frameInfo.commandBuffer);
+    bindDescriptorSets(frameInfo);
+    vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+    if (frameInfo.drawStream) {
+        frameInfo.drawStream->bindPipeline("deferred composite");
+        frameInfo.drawStream->bindDescriptorSets(0, 2);
+        frameInfo.drawStream->draw(3, 1);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../Pipeline.hpp"
+#include "../Device.hpp"
+#include "../Descriptors.hpp"
+#include "../FrameInfo.hpp"
+#include "../SwapChain.hpp"
+
+#include <memory>
+#include <vector>
+
+// Lighting and composite subpasses of the deferred render path
+class DeferredLightingSystem{
+    public:
+
+        DeferredLightingSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        ~DeferredLightingSystem();
+
+        DeferredLightingSystem(const DeferredLightingSystem&) = delete;
+        DeferredLightingSystem& operator=(const DeferredLightingSystem &) = delete;
+
+        // subpass 1: ambient term plus one additive light volume per point light
+        void renderLighting(FrameInfo& frameInfo, const GBufferViews& gBuffer, int numLights);
+        // subpass 2: resolves the hdr lighting attachment into the swapchain image
+        void renderComposite(FrameInfo& frameInfo);
+
+    private:
+        void createDescriptors();
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        void createPipelines(VkRenderPass renderPass);
+        void bindDescriptorSets(FrameInfo& frameInfo);
+
+        Device& device;
+
+        std::unique_ptr<DescriptorSetLayout> gBufferSetLayout;
+        std::unique_ptr<DescriptorPool> gBufferPool;
+        std::vector<VkDescriptorSet> gBufferDescriptorSets;
+        std::vector<GBufferViews> writtenViews;
+
+        std::unique_ptr<Pipeline> ambientPipeline;
+        std::unique_ptr<Pipeline> lightVolumePipeline;
+        std::unique_ptr<Pipeline> compositePipeline;
+        VkPipelineLayout pipelineLayout;
+};
@@ -0,0 +1,178 @@
+#include "LightClusterSystem.hpp"
+#include "../SwapChain.hpp"
+#include "../CpuProfiler.hpp"
+#include "../FrameCapture.hpp"
+#include <stdexcept>
+#include <cassert>
+#include <cstddef>
+
+LightClusterSystem::LightClusterSystem(Device& device, VkDescriptorSetLayout globalSetLayout, bool cpuCulling)
+    : device{device}, cpuCulling{cpuCulling} {
+    createPipelineLayout(globalSetLayout);
+    if (!cpuCulling) {
+        createPipeline();
+    }
+    createClusterBuffers();
+}
+
+LightClusterSystem::~LightClusterSystem() {
+    vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+}
+
+void LightClusterSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    if(vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipelineLayout");
+    }
+}
+
+void LightClusterSystem::createPipeline() {
+    assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+    pipeline = std::make_unique<ComputePipeline>(device, "../shaders/compiled_shaders/cluster_lights.comp.spv", pipelineLayout);
+}
+
+void LightClusterSystem::createClusterBuffers() {
+    clusterBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < clusterBuffers.size(); i++) {
+        clusterBuffers[i] = std::make_unique<Buffer>(
+            device,
+            sizeof(ClusterGrid),
+            1,
+            cpuCulling ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                       : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            cpuCulling ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        if (cpuCulling) {
+            clusterBuffers[i]->map();
+        }
+    }
+
+    if (cpuCulling) return;
+    overflowReadbacks.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (auto& readback : overflowReadbacks) {
+        readback = std::make_unique<Buffer>(
+            device,
+            sizeof(uint32_t),
+            1,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        readback->map();
+        uint32_t zero = 0;
+        readback->writeToBuffer(&zero);
+    }
+}
+
+void LightClusterSystem::compute(FrameInfo& frameInfo, const std::vector<PointLight>& lights) {
+    PROFILE_SCOPE("light culling");
+    if (cpuCulling) {
+        binner.bin(lights, frameInfo.camera.getView(), frameInfo.camera.getProjection(), frameInfo.camera.getNear());
+        uploadTiles(frameInfo.frameIndex);
+        if (frameInfo.drawStream) {
+            frameInfo.drawStream->bufferContents("light cluster counts", binner.getLightCounts().data(), binner.getLightCounts().size() * sizeof(uint32_t));
+        }
+        return;
+    }
+
+    // this frame index's fence has signaled, so its previous overflow count has landed
+    lastOverflowCount = *static_cast<const uint32_t*>(overflowReadbacks[frameInfo.frameIndex]->getMappedMemory());
+
+    VkBuffer grid = clusterBuffers[frameInfo.frameIndex]->getBuffer();
+    vkCmdFillBuffer(frameInfo.commandBuffer, grid, offsetof(ClusterGrid, overflowCount), sizeof(uint32_t), 0);
+    VkBufferMemoryBarrier clearBarrier{};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.buffer = grid;
+    clearBarrier.offset = offsetof(ClusterGrid, overflowCount);
+    clearBarrier.size = sizeof(uint32_t);
+    vkCmdPipelineBarrier(
+        frameInfo.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+
+    pipeline->bind(frameInfo.commandBuffer);
+
+    vkCmdBindDescriptorSets(
+        frameInfo.commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        pipelineLayout,
+        0,
+        1,
+        &frameInfo.globalDescriptorSet,
+        1,
+        &frameInfo.globalUboOffset);
+
+    // one workgroup covers a full XY slice of the froxel grid
+    vkCmdDispatch(frameInfo.commandBuffer, 1, 1, CLUSTER_Z);
+    if (frameInfo.drawStream) {
+        frameInfo.drawStream->bindPipeline("light culling");
+        frameInfo.drawStream->bindDescriptorSets(0, 1);
+        frameInfo.drawStream->dispatch(1, 1, CLUSTER_Z);
+    }
+    recordOverflowReadback(frameInfo.commandBuffer, frameInfo.frameIndex);
+}
+
+// Copies the overflow count to host memory, read back once this frame index comes around again
+void LightClusterSystem::recordOverflowReadback(VkCommandBuffer commandBuffer, int frameIndex) {
+    VkBuffer grid = clusterBuffers[frameIndex]->getBuffer();
+    VkBuffer readback = overflowReadbacks[frameIndex]->getBuffer();
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = grid;
+    barrier.offset = offsetof(ClusterGrid, overflowCount);
+    barrier.size = sizeof(uint32_t);
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VkBufferCopy region{};
+    region.srcOffset = offsetof(ClusterGrid, overflowCount);
+    region.dstOffset = 0;
+    region.size = sizeof(uint32_t);
+    vkCmdCopyBuffer(commandBuffer, grid, readback, 1, &region);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.buffer = readback;
+    barrier.offset = 0;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+// Tiles fill the first depth slice of the grid, the shaders clamp to it via ubo.clusterSlices
+void LightClusterSystem::uploadTiles(int frameIndex) {
+    auto& buffer = clusterBuffers[frameIndex];
+    auto& counts = binner.getLightCounts();
+    auto& indices = binner.getLightIndices();
+    VkDeviceSize countsSize = counts.size() * sizeof(uint32_t);
+    VkDeviceSize indicesSize = indices.size() * sizeof(uint32_t);
+    VkDeviceSize indicesOffset = offsetof(ClusterGrid, lightIndices);
+
+    lastOverflowCount = binner.getOverflowCount();
+
+    buffer->writeToBuffer(const_cast<uint32_t*>(counts.data()), countsSize, 0);
+    buffer->writeToBuffer(&lastOverflowCount, sizeof(uint32_t), offsetof(ClusterGrid, overflowCount));
+    buffer->writeToBuffer(const_cast<uint32_t*>(indices.data()), indicesSize, indicesOffset);
+    buffer->flush();
+}
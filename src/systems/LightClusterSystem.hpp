@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Pipeline.hpp"
+#include "../Device.hpp"
+#include "../Buffer.hpp"
+#include "../FrameInfo.hpp"
+#include "../LightBinning.hpp"
+
+#include <memory>
+#include <vector>
+
+class LightClusterSystem{
+    public:
+
+        // cpuCulling bins lights into screen tiles on the host instead of dispatching the froxel compute pass
+        LightClusterSystem(Device& device, VkDescriptorSetLayout globalSetLayout, bool cpuCulling = false);
+        ~LightClusterSystem();
+
+        LightClusterSystem(const LightClusterSystem&) = delete;
+        LightClusterSystem& operator=(const LightClusterSystem &) = delete;
+
+        // Must be recorded outside of a render pass. The barrier before draws that read the grid
+        // comes from the render graph, which sees this pass write it.
+        void compute(FrameInfo& frameInfo, const std::vector<PointLight>& lights);
+
+        VkDescriptorBufferInfo clusterBufferInfo(int frameIndex) { return clusterBuffers[frameIndex]->descriptorInfo(); }
+        // depth slices the shaders should index, host binned tiles only have one
+        int sliceCount() const { return cpuCulling ? 1 : CLUSTER_Z; }
+        // Light references dropped by full clusters, from the latest frame whose result is back.
+        // Nonzero means MAX_LIGHTS_PER_CLUSTER is too small for the scene.
+        uint32_t overflowCount() const { return lastOverflowCount; }
+
+    private:
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        void createPipeline();
+        void createClusterBuffers();
+        void uploadTiles(int frameIndex);
+        void recordOverflowReadback(VkCommandBuffer commandBuffer, int frameIndex);
+
+        Device& device;
+        bool cpuCulling;
+        LightBinner binner{CLUSTER_X, CLUSTER_Y, MAX_LIGHTS_PER_CLUSTER};
+
+        std::unique_ptr<ComputePipeline> pipeline;
+        VkPipelineLayout pipelineLayout;
+        std::vector<std::unique_ptr<Buffer>> clusterBuffers;
+        // ClusterGrid::overflowCount copied out of each frame's device local grid
+        std::vector<std::unique_ptr<Buffer>> overflowReadbacks;
+        uint32_t lastOverflowCount{0};
+};
@@ -1,4 +1,8 @@
 #include "PointLightSystem.hpp"
+#include "../RadixSort.hpp"
+#include "../GpuProfiler.hpp"
+#include "../CpuProfiler.hpp"
+#include "../FrameCapture.hpp"
 #include <stdexcept>
 #include <cassert>
 #include <array>
@@ -9,106 +13,306 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
-struct PointLightPushConstants {
-    glm::vec4 position{};
-    glm::vec4 color{};
-    float radius;
+// Lights contributing less than this are skipped by the cluster culling
+#define LIGHT_CUTOFF (1.f / 256.f)
+#define INITIAL_LIGHT_CAPACITY 64
+
+struct BindlessPushConstants {
+    uint32_t lightBuffer;
+    uint32_t drawOrder;
 };
 
-PointLightSystem::PointLightSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device} {
+PointLightSystem::PointLightSystem(Device& device, const RenderTarget& target, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath, bool sortBillboards, BindlessDescriptors* bindless)
+    : device{device}, renderPath{renderPath}, sortBillboards{sortBillboards}, bindless{bindless} {
+    // the bindless table replaces the per frame draw order sets
+    if (!bindless) {
+        createDescriptors();
+    }
     createPipelineLayout(globalSetLayout);
-    createPipeline(renderPass);
+    createPipeline(target);
+    createLightBuffers();
 }
 
 PointLightSystem::~PointLightSystem() {
+    if (bindless) {
+        for (uint32_t index : lightBufferIndices) {
+            bindless->releaseStorageBuffer(index);
+        }
+        for (uint32_t index : orderBufferIndices) {
+            bindless->releaseStorageBuffer(index);
+        }
+    }
     vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
 }
 
+void PointLightSystem::createDescriptors() {
+    orderSetLayout = DescriptorSetLayout::Builder(device)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+        .build();
+
+    orderPool = DescriptorPool::Builder(device)
+        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .build();
+
+    orderDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (auto& set : orderDescriptorSets) {
+        if (!orderPool->allocateDescriptor(orderSetLayout->getDescriptorSetLayout(), set)) {
+            throw std::runtime_error("Failed to allocate light draw order descriptor set");
+        }
+    }
+}
+
 void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+    VkDescriptorSetLayout secondSetLayout = bindless ? bindless->getSetLayout() : orderSetLayout->getDescriptorSetLayout();
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, secondSetLayout};
+
     VkPushConstantRange pushConstantRange{};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(PointLightPushConstants);
-
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+    pushConstantRange.size = sizeof(BindlessPushConstants);
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.pushConstantRangeCount = bindless ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = bindless ? &pushConstantRange : nullptr;
     if(vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipelineLayout");
     }
 }
 
-void PointLightSystem::createPipeline(VkRenderPass renderPass) {
+void PointLightSystem::createPipeline(const RenderTarget& target) {
     assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
     PipelineConfigInfo pipelineConfig{};
     Pipeline::defaultPipelineConfigInfo(pipelineConfig);
     pipelineConfig.attributeDescriptions.clear();
     pipelineConfig.bindingDescriptions.clear();
-    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.renderPass = target.renderPass;
+    pipelineConfig.colorAttachmentFormats = {target.colorFormat};
+    pipelineConfig.depthAttachmentFormat = target.depthFormat;
     pipelineConfig.pipelineLayout = pipelineLayout;
+    if(renderPath == RenderPath::Deferred) {
+        // drawn in the composite subpass where depth is read only
+        pipelineConfig.subpass = 2;
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    }
+    if(sortBillboards) {
+        // sorted back to front, so sprites blend over each other without writing depth
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+        pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        pipelineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        pipelineConfig.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        pipelineConfig.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
     pipeline = std::make_unique<Pipeline>(
         device,
-        "../shaders/compiled_shaders/point_light.vert.spv",
+        bindless ? "../shaders/compiled_shaders/point_light_bindless.vert.spv" : "../shaders/compiled_shaders/point_light.vert.spv",
         "../shaders/compiled_shaders/point_light.frag.spv",
         pipelineConfig);
 }
 
+void PointLightSystem::createLightBuffers() {
+    lightBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    uploadedVersions.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    orderBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    if (bindless) {
+        lightBufferIndices.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, BindlessDescriptors::INVALID_INDEX);
+        orderBufferIndices.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, BindlessDescriptors::INVALID_INDEX);
+    }
+    identityOrderSizes.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < lightBuffers.size(); i++) {
+        createLightBuffer(i, INITIAL_LIGHT_CAPACITY);
+        createOrderBuffer(i, INITIAL_LIGHT_CAPACITY);
+    }
+}
+
+// Only called for the frame being recorded, whose fence has already been waited on,
+// so the old buffer is no longer referenced by the GPU
+void PointLightSystem::createLightBuffer(int frameIndex, uint32_t capacity) {
+    // Buffer prefers coherent memory, otherwise only the rewritten slots get flushed
+    lightBuffers[frameIndex] = std::make_unique<Buffer>(
+        device,
+        sizeof(PointLight),
+        capacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    );
+    lightBuffers[frameIndex]->map();
+    uploadedVersions[frameIndex].clear();
+    if (bindless) {
+        registerBindless(lightBufferIndices[frameIndex], *lightBuffers[frameIndex]);
+    }
+}
+
+// Same lifetime rules as createLightBuffer, the set is rewritten here since this system owns it
+void PointLightSystem::createOrderBuffer(int frameIndex, uint32_t capacity) {
+    orderBuffers[frameIndex] = std::make_unique<Buffer>(
+        device,
+        sizeof(uint32_t),
+        capacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    );
+    orderBuffers[frameIndex]->map();
+    identityOrderSizes[frameIndex] = 0;
+
+    if (bindless) {
+        registerBindless(orderBufferIndices[frameIndex], *orderBuffers[frameIndex]);
+        return;
+    }
+    auto bufferInfo = orderBuffers[frameIndex]->descriptorInfo();
+    DescriptorWriter(*orderSetLayout, *orderPool)
+        .writeBuffer(0, &bufferInfo)
+        .overwrite(orderDescriptorSets[frameIndex]);
+}
+
+// A fresh index rather than an update in place, earlier frames may still read the old slot
+void PointLightSystem::registerBindless(uint32_t& index, Buffer& buffer) {
+    if (index != BindlessDescriptors::INVALID_INDEX) {
+        bindless->releaseStorageBuffer(index);
+    }
+    index = bindless->addStorageBuffer(buffer.descriptorInfo());
+}
+
 void PointLightSystem::update(FrameInfo& frameInfo, globalUbo& ubo) {
-    auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, {0.f, -1.f, 0.f});
-    int lightIndex = 0;
-    for (auto& kv: frameInfo.objects) {
-        auto& obj = kv.second;
-        if(obj.pointLight == nullptr) continue;
+    PROFILE_SCOPE("update point lights");
+    for (auto& sceneLight : frameInfo.scene.lights) {
+        //radius at which the 1/d^2 falloff drops below LIGHT_CUTOFF
+        float maxChannel = glm::max(sceneLight.color.r, glm::max(sceneLight.color.g, sceneLight.color.b));
+        float radius = glm::sqrt(sceneLight.intensity * maxChannel / LIGHT_CUTOFF);
+
+        PointLight light{};
+        light.position = glm::vec4(sceneLight.position, radius);
+        light.color = glm::vec4(sceneLight.color, sceneLight.intensity);
+        light.billboard.x = sceneLight.radius;
+
+        uint32_t index = sceneLight.entity & ENTITY_INDEX_MASK;
+        if (index >= lightHandles.size()) {
+            lightHandles.resize(index + 1);
+        }
+        LightHandle& handle = lightHandles[index];
+        if (handle.entity == sceneLight.entity && lightRegistry.contains(handle.lightId)) {
+            lightRegistry.set(handle.lightId, light);
+        } else {
+            handle = {sceneLight.entity, lightRegistry.add(light)};
+        }
+    }
+    //lights whose entities were destroyed
+    lightRegistry.removeUntouched();
+
+    ubo.numLights = static_cast<int>(lightRegistry.size());
+    uploadLights(frameInfo.frameIndex);
+    uploadDrawOrder(frameInfo);
+}
+
+void PointLightSystem::uploadLights(int frameIndex) {
+    auto& lights = lightRegistry.getLights();
+    auto& versions = lightRegistry.getVersions();
+    if (lights.size() > lightBuffers[frameIndex]->getInstanceCount()) {
+        uint32_t capacity = lightBuffers[frameIndex]->getInstanceCount();
+        while (capacity < lights.size()) {
+            capacity *= 2;
+        }
+        createLightBuffer(frameIndex, capacity);
+    }
+
+    //newly grown slots start at version 0, which is never stored in the registry
+    auto& uploaded = uploadedVersions[frameIndex];
+    uploaded.resize(lights.size(), 0);
 
-        assert(lightIndex < MAX_LIGHTS && "Too many light in one scene; Max amount of lights is " && MAX_LIGHTS);
+    //write contiguous runs of stale slots
+    size_t slot = 0;
+    while (slot < lights.size()) {
+        if (uploaded[slot] == versions[slot]) {
+            slot++;
+            continue;
+        }
+        size_t first = slot;
+        for (; slot < lights.size() && uploaded[slot] != versions[slot]; slot++) {
+            uploaded[slot] = versions[slot];
+        }
+        lightBuffers[frameIndex]->writeToBuffer(
+            const_cast<PointLight*>(&lights[first]),
+            (slot - first) * sizeof(PointLight),
+            first * sizeof(PointLight));
+    }
+    lightBuffers[frameIndex]->flush();
+}
 
-        //update light position
-        obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-    
-        //copy light to ubo
-        ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-        ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+void PointLightSystem::uploadDrawOrder(FrameInfo& frameInfo) {
+    auto& lights = lightRegistry.getLights();
+    uint32_t count = static_cast<uint32_t>(lights.size());
+    auto& buffer = orderBuffers[frameInfo.frameIndex];
+    if (count > buffer->getInstanceCount()) {
+        uint32_t capacity = buffer->getInstanceCount();
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        createOrderBuffer(frameInfo.frameIndex, capacity);
+    }
+    if (count == 0) return;
 
-        lightIndex += 1;
+    if (!sortBillboards) {
+        // the identity order only has to be written when the light count changes
+        if (identityOrderSizes[frameInfo.frameIndex] == count) return;
+        drawOrder.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            drawOrder[i] = i;
+        }
+        identityOrderSizes[frameInfo.frameIndex] = count;
+    } else {
+        // view space z grows away from the camera, negate it so the farthest light sorts first
+        const glm::mat4& view = frameInfo.camera.getView();
+        sortKeys.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const glm::vec4& p = lights[i].position;
+            float viewZ = view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2];
+            sortKeys[i] = floatSortKey(-viewZ);
+        }
+        radixSort(sortKeys, drawOrder, sortScratch);
     }
-    ubo.numLights = lightIndex;
+    buffer->writeToBuffer(drawOrder.data(), count * sizeof(uint32_t));
+    buffer->flush();
 }
 
 void PointLightSystem::render(FrameInfo& frameInfo) {
+    uint32_t count = static_cast<uint32_t>(lightRegistry.size());
+    if (count == 0) return;
+
+    PROFILE_SCOPE("point lights");
+    GpuProfiler::Scope scope{frameInfo.profiler, frameInfo.commandBuffer, "point lights", true};
     pipeline->bind(frameInfo.commandBuffer);
 
+    VkDescriptorSet secondSet = bindless ? bindless->getDescriptorSet() : orderDescriptorSets[frameInfo.frameIndex];
+    std::array<VkDescriptorSet, 2> descriptorSets{frameInfo.globalDescriptorSet, secondSet};
     vkCmdBindDescriptorSets(
         frameInfo.commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         pipelineLayout,
         0,
+        static_cast<uint32_t>(descriptorSets.size()),
+        descriptorSets.data(),
         1,
-        &frameInfo.globalDescriptorSet,
-        0,
-        nullptr);
-
-    for (auto& kv: frameInfo.objects) {
-        auto& obj = kv.second;
-        if(obj.pointLight == nullptr) continue;
-
-        PointLightPushConstants push{};
-        push.position = glm::vec4(obj.transform.translation, 1.f);
-        push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-        push.radius = obj.transform.scale.x;
-
-        vkCmdPushConstants(
-            frameInfo.commandBuffer,
-            pipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(PointLightPushConstants),
-            &push
-        );
-        vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-    }
-}
\ No newline at end of file
+        &frameInfo.globalUboOffset);
+    BindlessPushConstants push{};
+    if (bindless) {
+        push = {lightBufferIndices[frameInfo.frameIndex], orderBufferIndices[frameInfo.frameIndex]};
+        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+    }
+
+    // one billboard instance per light, the vertex shader fetches everything from the light buffer
+    vkCmdDraw(frameInfo.commandBuffer, 6, count, 0, 0);
+    if (frameInfo.drawStream) {
+        frameInfo.drawStream->bindPipeline("point lights");
+        frameInfo.drawStream->bindDescriptorSets(0, static_cast<uint32_t>(descriptorSets.size()));
+        if (bindless) {
+            frameInfo.drawStream->pushConstants(0, sizeof(push), &push);
+        }
+        frameInfo.drawStream->draw(6, count);
+    }
+}
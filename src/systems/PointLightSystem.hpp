@@ -1,10 +1,15 @@
 #pragma once
 
 #include "../Pipeline.hpp"
-#include "../Object.hpp"
+#include "../Components.hpp"
 #include "../Device.hpp"
 #include "../Camera.hpp"
 #include "../FrameInfo.hpp"
+#include "../Buffer.hpp"
+#include "../SwapChain.hpp"
+#include "../LightRegistry.hpp"
+#include "../Descriptors.hpp"
+#include "../BindlessDescriptors.hpp"
 
 #include <memory>
 #include <vector>
@@ -12,7 +17,9 @@
 class PointLightSystem{
     public:
 
-        PointLightSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        // sortBillboards draws soft alpha blended sprites back to front instead of opaque discs.
+        // With bindless set, the light and draw order buffers are read from its table by index.
+        PointLightSystem(Device& device, const RenderTarget& target, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath = RenderPath::Forward, bool sortBillboards = false, BindlessDescriptors* bindless = nullptr);
         ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem&) = delete;
@@ -21,11 +28,50 @@ class PointLightSystem{
         void update(FrameInfo& frameinfo, globalUbo& ubo);
         void render(FrameInfo& frameInfo);
 
+        VkDescriptorBufferInfo lightBufferInfo(int frameIndex) { return lightBuffers[frameIndex]->descriptorInfo(); }
+        const std::vector<PointLight>& getLights() const { return lightRegistry.getLights(); }
+
     private:
+        void createDescriptors();
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(const RenderTarget& target);
+        void createLightBuffers();
+        void createLightBuffer(int frameIndex, uint32_t capacity);
+        void createOrderBuffer(int frameIndex, uint32_t capacity);
+        void uploadLights(int frameIndex);
+        void uploadDrawOrder(FrameInfo& frameInfo);
+        // points index at buffer in the bindless table, releasing the buffer it pointed at before
+        void registerBindless(uint32_t& index, Buffer& buffer);
 
         Device& device;
+        RenderPath renderPath;
+        bool sortBillboards;
+        LightRegistry lightRegistry;
+        // light registry handle of each light entity, indexed by entity index
+        struct LightHandle {
+            Entity entity = NULL_ENTITY;
+            LightRegistry::id_t lightId = LightRegistry::INVALID_ID;
+        };
+        std::vector<LightHandle> lightHandles;
+        // Grows on demand, App rewrites the descriptor when the buffer handle changes
+        std::vector<std::unique_ptr<Buffer>> lightBuffers;
+        // Registry slot versions last written to each frame's buffer
+        std::vector<std::vector<uint64_t>> uploadedVersions;
+
+        // per frame light indices in draw order, read by point_light.vert through gl_InstanceIndex
+        std::unique_ptr<DescriptorSetLayout> orderSetLayout;
+        std::unique_ptr<DescriptorPool> orderPool;
+        std::vector<VkDescriptorSet> orderDescriptorSets;
+        std::vector<std::unique_ptr<Buffer>> orderBuffers;
+        std::vector<uint32_t> identityOrderSizes;
+        std::vector<uint32_t> sortKeys;
+        std::vector<uint32_t> drawOrder;
+        std::vector<uint32_t> sortScratch;
+
+        // bindless table indices of each frame's buffers, pushed to point_light_bindless.vert
+        BindlessDescriptors* bindless;
+        std::vector<uint32_t> lightBufferIndices;
+        std::vector<uint32_t> orderBufferIndices;
 
         std::unique_ptr<Pipeline> pipeline;
         VkPipelineLayout pipelineLayout;
@@ -1,4 +1,9 @@
 #include "RenderSystem.hpp"
+#include "../GpuProfiler.hpp"
+#include "../CpuProfiler.hpp"
+#include "../FrameCapture.hpp"
+#include "../JobSystem.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 #include <array>
@@ -8,14 +13,17 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+// draws per secondary command buffer when recording from jobs
+#define OBJECTS_PER_SECONDARY 256
+
 struct PushConstantData {
     glm::mat4 modelMatrix{1.f};
     glm::mat4 normalMatrix{1.f};
 };
 
-RenderSystem::RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device} {
+RenderSystem::RenderSystem(Device& device, const RenderTarget& target, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath) : device{device}, renderPath{renderPath} {
     createPipelineLayout(globalSetLayout);
-    createPipeline(renderPass);
+    createPipeline(target);
 }
 
 RenderSystem::~RenderSystem() {
@@ -42,44 +50,86 @@ void RenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
     }
 }
 
-void RenderSystem::createPipeline(VkRenderPass renderPass) {
+void RenderSystem::createPipeline(const RenderTarget& target) {
     assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
     PipelineConfigInfo pipelineConfig{};
     Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.renderPass = target.renderPass;
+    pipelineConfig.colorAttachmentFormats = {target.colorFormat};
+    pipelineConfig.depthAttachmentFormat = target.depthFormat;
     pipelineConfig.pipelineLayout = pipelineLayout;
+
+    if(renderPath == RenderPath::Deferred) {
+        // g-buffer subpass writes albedo and normal
+        std::array<VkPipelineColorBlendAttachmentState, 2> blendAttachments{pipelineConfig.colorBlendAttachment, pipelineConfig.colorBlendAttachment};
+        pipelineConfig.colorBlendInfo.attachmentCount = static_cast<uint32_t>(blendAttachments.size());
+        pipelineConfig.colorBlendInfo.pAttachments = blendAttachments.data();
+        pipelineConfig.subpass = 0;
+        pipeline = std::make_unique<Pipeline>(device, "../shaders/compiled_shaders/simple_shader.vert.spv", "../shaders/compiled_shaders/gbuffer.frag.spv", pipelineConfig);
+        return;
+    }
+
     pipeline = std::make_unique<Pipeline>(device, "../shaders/compiled_shaders/simple_shader.vert.spv", "../shaders/compiled_shaders/simple_shader.frag.spv", pipelineConfig);
 }
 
 void RenderSystem::renderObjects(FrameInfo& frameInfo) {
-    pipeline->bind(frameInfo.commandBuffer);
+    PROFILE_SCOPE("render objects");
+    GpuProfiler::Scope scope{frameInfo.profiler, frameInfo.commandBuffer, "render objects", true};
+    bindPipeline(frameInfo, frameInfo.commandBuffer);
+    if (frameInfo.drawStream) {
+        frameInfo.drawStream->bindPipeline("render objects");
+        frameInfo.drawStream->bindDescriptorSets(0, 1);
+    }
+    drawObjects(frameInfo, frameInfo.commandBuffer, 0, frameInfo.scene.objects.size());
+}
+
+void RenderSystem::recordObjects(FrameInfo& frameInfo, SecondaryCommandBuffers& secondaries, const SecondaryTarget& target, std::vector<VkCommandBuffer>& commandBuffers) {
+    PROFILE_SCOPE("record objects");
+    size_t count = frameInfo.scene.objects.size();
+    size_t chunks = (count + OBJECTS_PER_SECONDARY - 1) / OBJECTS_PER_SECONDARY;
+    size_t first = commandBuffers.size();
+    commandBuffers.resize(first + chunks);
+    JobSystem::shared().parallelFor(chunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t chunk = chunkBegin; chunk < chunkEnd; chunk++) {
+            commandBuffers[first + chunk] = secondaries.record(target, [&](VkCommandBuffer commandBuffer) {
+                bindPipeline(frameInfo, commandBuffer);
+                size_t begin = chunk * OBJECTS_PER_SECONDARY;
+                drawObjects(frameInfo, commandBuffer, begin, std::min(begin + OBJECTS_PER_SECONDARY, count));
+            });
+        }
+    });
+}
 
+void RenderSystem::bindPipeline(FrameInfo& frameInfo, VkCommandBuffer commandBuffer) {
+    pipeline->bind(commandBuffer);
     vkCmdBindDescriptorSets(
-        frameInfo.commandBuffer,
+        commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         pipelineLayout,
         0,
         1,
         &frameInfo.globalDescriptorSet,
-        0,
-        nullptr
+        1,
+        &frameInfo.globalUboOffset
     );
+}
 
-    for (auto& kv: frameInfo.objects) {
-        auto& obj = kv.second;
-        if (obj.model == nullptr) continue;
-        if(obj.shouldRotateY) {
-           obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.0005f, glm::two_pi<float>()); 
-        }
-        //obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.0005f, glm::two_pi<float>());
-        //obj.transform.rotation.x = glm::mod(obj.transform.rotation.x + 0.0001f, glm::two_pi<float>());
-
+// only logs to the draw stream when recording into the frame's own command buffer
+void RenderSystem::drawObjects(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+    DrawStream* drawStream = commandBuffer == frameInfo.commandBuffer ? frameInfo.drawStream : nullptr;
+    for (size_t i = begin; i < end; i++) {
+        const RenderObject& object = frameInfo.scene.objects[i];
         PushConstantData push{};
-        push.modelMatrix = obj.transform.mat4();
-        push.normalMatrix = obj.transform.normalMatrix();
+        push.modelMatrix = object.modelMatrix;
+        push.normalMatrix = object.normalMatrix;
 
-        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
-        obj.model->bind(frameInfo.commandBuffer);
-        obj.model->draw(frameInfo.commandBuffer);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
+        object.model->bind(commandBuffer);
+        object.model->draw(commandBuffer);
+        if (drawStream) {
+            drawStream->pushConstants(0, sizeof(PushConstantData), &push);
+            drawStream->bindModel(object.model);
+            drawStream->drawModel(object.model);
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "../Pipeline.hpp"
-#include "../Object.hpp"
+#include "../Components.hpp"
 #include "../Device.hpp"
 #include "../Camera.hpp"
 #include "../FrameInfo.hpp"
+#include "../SwapChain.hpp"
+#include "../SecondaryCommandBuffers.hpp"
 
 #include <memory>
 #include <vector>
@@ -12,19 +14,25 @@
 class RenderSystem{
     public:
 
-        RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        RenderSystem(Device& device, const RenderTarget& target, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath = RenderPath::Forward);
         ~RenderSystem();
 
         RenderSystem(const RenderSystem&) = delete;
         RenderSystem& operator=(const RenderSystem &) = delete;
 
         void renderObjects(FrameInfo& frameInfo);
+        // Records the scene objects from jobs, a chunk per secondary, and appends the buffers in
+        // draw order. Neither the gpu profiler nor the draw stream is written.
+        void recordObjects(FrameInfo& frameInfo, SecondaryCommandBuffers& secondaries, const SecondaryTarget& target, std::vector<VkCommandBuffer>& commandBuffers);
 
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(const RenderTarget& target);
+        void bindPipeline(FrameInfo& frameInfo, VkCommandBuffer commandBuffer);
+        void drawObjects(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, size_t begin, size_t end);
 
         Device& device;
+        RenderPath renderPath;
 
         std::unique_ptr<Pipeline> pipeline;
         VkPipelineLayout pipelineLayout;
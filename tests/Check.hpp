@@ -0,0 +1,29 @@
+#pragma once
+
+#include <iostream>
+
+// Assertions for the test executables. A failed check prints where it failed and the test
+// keeps going, finish() turns the failure count into the exit code.
+namespace check {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int finish(const char* test) {
+        if (failures() == 0) {
+            std::cout << test << ": passed\n";
+            return 0;
+        }
+        std::cout << test << ": " << failures() << " checks failed\n";
+        return 1;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            check::failures()++; \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+        } \
+    } while (0)
@@ -0,0 +1,86 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#define JOB_COUNT 1000000
+#define ITERATIONS 5
+
+namespace {
+    template<typename Func>
+    double bestMilliseconds(Func func) {
+        double best = 1e30;
+        for (int i = 0; i < ITERATIONS; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    void report(const char* name, double ms, size_t items, const char* unit) {
+        std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << ms << " ms" << std::setw(10) << std::setprecision(2) << items / ms / 1000.0 << " M " << unit << "/s\n";
+    }
+
+    // a little work per job so stealing has something to balance
+    void spin(std::atomic<uint64_t>& sink) {
+        uint64_t value = 0;
+        for (int i = 0; i < 200; i++) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        sink.fetch_add(value & 1, std::memory_order_relaxed);
+    }
+}
+
+int main() {
+    JobSystem& jobs = JobSystem::shared();
+    std::atomic<uint64_t> sink{0};
+    std::cout << jobs.getWorkerCount() << " workers, best of " << ITERATIONS << "\n";
+
+    // every job goes through the queue of the submitting thread
+    report("run + wait, empty jobs", bestMilliseconds([&] {
+        JobCounter counter;
+        for (int i = 0; i < JOB_COUNT; i++) {
+            jobs.run([]() {}, &counter);
+        }
+        jobs.wait(counter);
+    }), JOB_COUNT, "jobs");
+
+    // ranges are split per thread, so this measures how evenly the items are spread
+    report("parallelFor over spinning items", bestMilliseconds([&] {
+        jobs.parallelFor(JOB_COUNT, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                spin(sink);
+            }
+        });
+    }), JOB_COUNT, "items");
+
+    // One worker fills its own deque while every other thread can only get work by stealing
+    // from the front of it
+    std::atomic<size_t> stolen{0};
+    double stealMs = bestMilliseconds([&] {
+        JobCounter counter;
+        jobs.run([&]() {
+            std::thread::id owner = std::this_thread::get_id();
+            for (int i = 0; i < JOB_COUNT / 10; i++) {
+                jobs.run([&, owner]() {
+                    spin(sink);
+                    if (std::this_thread::get_id() != owner) {
+                        stolen.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }, &counter);
+            }
+        }, &counter);
+        jobs.wait(counter);
+    });
+    report("single producer, stolen by others", stealMs, JOB_COUNT / 10, "jobs");
+    std::cout << std::setprecision(1) << 100.0 * stolen.load() / (ITERATIONS * (JOB_COUNT / 10)) << "% of those jobs ran on a thread other than the producer\n";
+
+    return sink.load() == UINT64_MAX ? 1 : 0;
+}
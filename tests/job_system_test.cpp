@@ -0,0 +1,156 @@
+#include "Check.hpp"
+
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    void checkRunAndWait(JobSystem& jobs) {
+        std::atomic<int> ran{0};
+        JobCounter counter;
+        for (int i = 0; i < 10000; i++) {
+            jobs.run([&ran]() { ran++; }, &counter);
+        }
+        jobs.wait(counter);
+        CHECK(counter.done());
+        CHECK(ran.load() == 10000);
+    }
+
+    // a continuation only starts once every job of its dependency has finished
+    void checkContinuations(JobSystem& jobs) {
+        for (int round = 0; round < 200; round++) {
+            std::atomic<int> ran{0};
+            std::atomic<int> seenByContinuation{-1};
+            JobCounter dependency, all;
+            for (int i = 0; i < 64; i++) {
+                jobs.run([&ran]() { ran++; }, &dependency);
+            }
+            jobs.runAfter(dependency, [&]() { seenByContinuation = ran.load(); }, &all);
+            // waiting on all covers the deferred job as well
+            jobs.wait(all);
+            CHECK(seenByContinuation.load() == 64);
+        }
+    }
+
+    void checkRunAfterFinishedDependency(JobSystem& jobs) {
+        JobCounter dependency, counter;
+        std::atomic<bool> ran{false};
+        jobs.runAfter(dependency, [&ran]() { ran = true; }, &counter);
+        jobs.wait(counter);
+        CHECK(ran.load());
+    }
+
+    // each stage is queued behind the previous one and has to observe all of its writes
+    void checkContinuationChain(JobSystem& jobs) {
+        const int stages = 32;
+        std::vector<int> values(stages, 0);
+        std::vector<JobCounter> counters(stages);
+        jobs.run([&values]() { values[0] = 1; }, &counters[0]);
+        for (int stage = 1; stage < stages; stage++) {
+            jobs.runAfter(counters[stage - 1], [&values, stage]() { values[stage] = values[stage - 1] + 1; }, &counters[stage]);
+        }
+        // a later stage reaching zero does not mean the earlier counters are no longer referenced
+        for (auto& counter : counters) {
+            jobs.wait(counter);
+        }
+        CHECK(values[stages - 1] == stages);
+    }
+
+    void checkParallelFor(JobSystem& jobs) {
+        const size_t count = 100003;
+        std::vector<std::atomic<int>> visits(count);
+        jobs.parallelFor(count, 16, [&visits](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                visits[i]++;
+            }
+        });
+        int wrong = 0;
+        for (auto& visit : visits) {
+            if (visit.load() != 1) wrong++;
+        }
+        CHECK(wrong == 0);
+    }
+
+    // inner loops wait from inside jobs, which only finishes because waiting threads run jobs
+    void checkNestedParallelFor(JobSystem& jobs) {
+        const size_t outer = 64, inner = 1000;
+        std::vector<std::atomic<int>> visits(outer * inner);
+        jobs.parallelFor(outer, 1, [&](size_t outerBegin, size_t outerEnd) {
+            for (size_t o = outerBegin; o < outerEnd; o++) {
+                jobs.parallelFor(inner, 8, [&visits, o, inner](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        visits[o * inner + i]++;
+                    }
+                });
+            }
+        });
+        int wrong = 0;
+        for (auto& visit : visits) {
+            if (visit.load() != 1) wrong++;
+        }
+        CHECK(wrong == 0);
+    }
+
+    // With one worker busy on a job that needs another job to run first, only the waiting
+    // thread is left to run it
+    void checkWaitHelps() {
+        JobSystem jobs{1};
+        std::atomic<bool> blockerStarted{false};
+        std::atomic<bool> released{false};
+        JobCounter blocker;
+        jobs.run([&]() {
+            blockerStarted = true;
+            while (!released) {
+                std::this_thread::yield();
+            }
+        }, &blocker);
+        while (!blockerStarted) {
+            std::this_thread::yield();
+        }
+
+        std::thread::id releasedOn;
+        JobCounter release;
+        jobs.run([&]() {
+            releasedOn = std::this_thread::get_id();
+            released = true;
+        }, &release);
+        jobs.wait(release);
+        jobs.wait(blocker);
+        CHECK(releasedOn == std::this_thread::get_id());
+    }
+
+    // the same on a worker: a job waiting on its own children runs them when nobody else can
+    void checkWaitHelpsInsideJobs() {
+        JobSystem jobs{1};
+        std::atomic<int> ran{0};
+        JobCounter outer;
+        for (int i = 0; i < 8; i++) {
+            jobs.run([&]() {
+                JobCounter children;
+                for (int child = 0; child < 16; child++) {
+                    jobs.run([&ran]() { ran++; }, &children);
+                }
+                jobs.wait(children);
+            }, &outer);
+        }
+        jobs.wait(outer);
+        CHECK(ran.load() == 8 * 16);
+    }
+}
+
+int main() {
+    JobSystem jobs{4};
+    for (int repeat = 0; repeat < 3; repeat++) {
+        checkRunAndWait(jobs);
+        checkContinuations(jobs);
+        checkRunAfterFinishedDependency(jobs);
+        checkContinuationChain(jobs);
+        checkParallelFor(jobs);
+        checkNestedParallelFor(jobs);
+    }
+    checkWaitHelps();
+    checkWaitHelpsInsideJobs();
+    return check::finish("job_system_test");
+}
@@ -0,0 +1,155 @@
+#include "Check.hpp"
+
+#include "Camera.hpp"
+#include "LightBinning.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define TILES_X 16
+#define TILES_Y 9
+// enough that no tile overflows, so every overlap has to show up in the tile lists
+#define UNCAPPED_LIGHTS_PER_TILE 4096
+// sphere surface samples for the brute force reference, per axis
+#define SAMPLES_AROUND 64
+#define SAMPLES_UP 32
+
+namespace {
+    std::vector<PointLight> randomLights(std::mt19937& rng, size_t count) {
+        std::uniform_real_distribution<float> position(-20.f, 20.f);
+        std::uniform_real_distribution<float> radius(0.05f, 4.f);
+        std::vector<PointLight> lights(count);
+        for (auto& light : lights) {
+            light.position = glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+        }
+        return lights;
+    }
+
+    bool tileHasLight(const LightBinner& binner, uint32_t maxLightsPerTile, uint32_t tile, uint32_t light) {
+        uint32_t count = binner.getLightCounts()[tile];
+        const uint32_t* indices = &binner.getLightIndices()[tile * maxLightsPerTile];
+        for (uint32_t i = 0; i < count; i++) {
+            if (indices[i] == light) return true;
+        }
+        return false;
+    }
+
+    // Tiles the sphere covers on screen, found by projecting points on its surface. Sampling can
+    // only miss thin slivers, so every tile it reports has to be in the binner's lists.
+    std::vector<bool> referenceTiles(glm::vec3 center, float radius, const glm::mat4& projection) {
+        std::vector<bool> covered(TILES_X * TILES_Y, false);
+        for (int up = 0; up <= SAMPLES_UP; up++) {
+            float theta = glm::pi<float>() * up / SAMPLES_UP;
+            for (int around = 0; around < SAMPLES_AROUND; around++) {
+                float phi = glm::two_pi<float>() * around / SAMPLES_AROUND;
+                glm::vec3 point = center + radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                glm::vec4 clip = projection * glm::vec4(point, 1.f);
+                float tileX = (clip.x / clip.w * 0.5f + 0.5f) * TILES_X;
+                float tileY = (clip.y / clip.w * 0.5f + 0.5f) * TILES_Y;
+                if (tileX < 0.f || tileY < 0.f || tileX >= TILES_X || tileY >= TILES_Y) continue;
+                covered[static_cast<int>(tileY) * TILES_X + static_cast<int>(tileX)] = true;
+            }
+        }
+        return covered;
+    }
+
+    void checkAgainstBruteForce(std::mt19937& rng, const Camera& camera, size_t lightCount) {
+        std::vector<PointLight> lights = randomLights(rng, lightCount);
+        LightBinner binner{TILES_X, TILES_Y, UNCAPPED_LIGHTS_PER_TILE};
+        binner.bin(lights, camera.getView(), camera.getProjection(), camera.getNear());
+        CHECK(binner.getOverflowCount() == 0);
+
+        uint32_t misses = 0;
+        uint32_t wrongCulls = 0;
+        for (uint32_t light = 0; light < lights.size(); light++) {
+            glm::vec3 center = camera.getView() * glm::vec4(glm::vec3(lights[light].position), 1.f);
+            float radius = lights[light].position.w;
+            if (center.z + radius <= camera.getNear()) {
+                const LightBinner::TileRect& rect = binner.getTileRects()[light];
+                if (rect.minX <= rect.maxX) wrongCulls++;
+                continue;
+            }
+            // spheres crossing the near plane are binned to every tile
+            bool crossesNear = center.z - radius < camera.getNear();
+            std::vector<bool> covered = referenceTiles(center, radius, camera.getProjection());
+            for (uint32_t tile = 0; tile < TILES_X * TILES_Y; tile++) {
+                if ((crossesNear || covered[tile]) && !tileHasLight(binner, UNCAPPED_LIGHTS_PER_TILE, tile, light)) {
+                    misses++;
+                }
+            }
+        }
+        CHECK(misses == 0);
+        CHECK(wrongCulls == 0);
+
+        // lists are filled in light order
+        for (uint32_t tile = 0; tile < TILES_X * TILES_Y; tile++) {
+            const uint32_t* indices = &binner.getLightIndices()[tile * UNCAPPED_LIGHTS_PER_TILE];
+            for (uint32_t i = 1; i < binner.getLightCounts()[tile]; i++) {
+                CHECK(indices[i - 1] < indices[i]);
+            }
+        }
+    }
+
+    void checkSimdMatchesScalar(std::mt19937& rng, const Camera& camera, size_t lightCount) {
+        std::vector<PointLight> lights = randomLights(rng, lightCount);
+        LightBinner simd{TILES_X, TILES_Y, UNCAPPED_LIGHTS_PER_TILE};
+        LightBinner scalar{TILES_X, TILES_Y, UNCAPPED_LIGHTS_PER_TILE};
+        scalar.setSimdEnabled(false);
+        simd.bin(lights, camera.getView(), camera.getProjection(), camera.getNear());
+        scalar.bin(lights, camera.getView(), camera.getProjection(), camera.getNear());
+
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < lights.size(); i++) {
+            const LightBinner::TileRect& a = simd.getTileRects()[i];
+            const LightBinner::TileRect& b = scalar.getTileRects()[i];
+            if (a.minX != b.minX || a.minY != b.minY || a.maxX != b.maxX || a.maxY != b.maxY) {
+                mismatches++;
+            }
+        }
+        CHECK(mismatches == 0);
+        CHECK(simd.getLightCounts() == scalar.getLightCounts());
+    }
+
+    void checkOverflowCount(std::mt19937& rng, const Camera& camera) {
+        const uint32_t cap = 8;
+        std::vector<PointLight> lights = randomLights(rng, 2000);
+        LightBinner capped{TILES_X, TILES_Y, cap};
+        capped.bin(lights, camera.getView(), camera.getProjection(), camera.getNear());
+
+        // every covered tile past the cap is one dropped reference
+        uint32_t expected = 0;
+        std::vector<uint32_t> hits(TILES_X * TILES_Y, 0);
+        for (const auto& rect : capped.getTileRects()) {
+            for (int32_t y = rect.minY; y <= rect.maxY; y++) {
+                for (int32_t x = rect.minX; x <= rect.maxX; x++) {
+                    if (++hits[y * TILES_X + x] > cap) expected++;
+                }
+            }
+        }
+        CHECK(expected > 0);
+        CHECK(capped.getOverflowCount() == expected);
+        for (uint32_t count : capped.getLightCounts()) {
+            CHECK(count <= cap);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+
+    for (int view = 0; view < 8; view++) {
+        Camera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, 0.1f, 100.f);
+        camera.setViewYXZ(glm::vec3(0.f), glm::vec3(0.5f * angle(rng), angle(rng), 0.f));
+        // small counts bin on the calling thread, large ones in parallel by row
+        checkAgainstBruteForce(rng, camera, 61);
+        checkAgainstBruteForce(rng, camera, 1000);
+        checkSimdMatchesScalar(rng, camera, 4001);
+        checkOverflowCount(rng, camera);
+    }
+    return check::finish("light_binning_test");
+}
@@ -0,0 +1,139 @@
+#include "Components.hpp"
+#include "Registry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// one in every MODEL_STRIDE entities is drawable and one in every LIGHT_STRIDE is a light
+#define MODEL_STRIDE 3
+#define LIGHT_STRIDE 10
+#define ITERATIONS 20
+
+// The scene container the registry replaced: every object in one hash map with its optional
+// parts behind pointers, and every system filtering the whole map
+namespace legacy {
+    struct Transform {
+        glm::vec3 translation{};
+        glm::vec3 scale{1.f, 1.f, 1.f};
+        glm::vec3 rotation{};
+    };
+
+    struct PointLight {
+        float lightIntensity = 1.f;
+        uint32_t lightId = UINT32_MAX;
+    };
+
+    struct Object {
+        glm::vec3 color{};
+        Transform transform{};
+        std::shared_ptr<Model> model{};
+        std::unique_ptr<PointLight> pointLight = nullptr;
+        bool shouldRotateY{false};
+        int useSpec{1};
+    };
+
+    using Map = std::unordered_map<unsigned int, Object>;
+}
+
+namespace {
+    // never dereferenced, drawables only need a non null model to be told apart
+    Model* placeholderModel() {
+        static char storage;
+        return reinterpret_cast<Model*>(&storage);
+    }
+
+    template<typename Func>
+    double bestMilliseconds(Func func) {
+        std::vector<double> times;
+        for (int i = 0; i < ITERATIONS; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            auto end = std::chrono::high_resolution_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return *std::min_element(times.begin(), times.end());
+    }
+
+    void report(const char* name, double registryMs, double legacyMs) {
+        std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << registryMs << " ms" << std::setw(10) << legacyMs << " ms"
+            << std::setw(8) << std::setprecision(1) << legacyMs / registryMs << "x\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    Registry registry;
+    legacy::Map objects;
+    objects.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        float position = static_cast<float>(i);
+        Entity entity = registry.create();
+        registry.add<TransformComponent>(entity).translation = glm::vec3(position, 0.f, 0.f);
+        registry.add<ColorComponent>(entity);
+
+        legacy::Object object{};
+        object.transform.translation = glm::vec3(position, 0.f, 0.f);
+        if (i % MODEL_STRIDE == 0) {
+            registry.add<ModelComponent>(entity, {placeholderModel()});
+            object.model = std::shared_ptr<Model>(std::shared_ptr<Model>{}, placeholderModel());
+        }
+        if (i % LIGHT_STRIDE == 0) {
+            registry.add<PointLightComponent>(entity);
+            object.pointLight = std::make_unique<legacy::PointLight>();
+        }
+        objects.emplace(static_cast<unsigned int>(i), std::move(object));
+    }
+
+    // the sums keep the loops from being optimized away, and being sums of whole numbers they
+    // also check that both containers visit the same objects
+    double registrySum = 0.0, legacySum = 0.0;
+
+    std::cout << count << " entities, best of " << ITERATIONS << "\n";
+    std::cout << std::left << std::setw(28) << "" << std::right << std::setw(13) << "registry" << std::setw(13) << "Object::Map" << "\n";
+
+    report("transforms", bestMilliseconds([&] {
+        registry.view<TransformComponent>().each([&](Entity, TransformComponent& transform) {
+            registrySum += transform.translation.x;
+        });
+    }), bestMilliseconds([&] {
+        for (auto& kv : objects) {
+            legacySum += kv.second.transform.translation.x;
+        }
+    }));
+
+    report("transform + model", bestMilliseconds([&] {
+        registry.view<TransformComponent, ModelComponent>().each([&](Entity, TransformComponent& transform, ModelComponent&) {
+            registrySum += transform.translation.x;
+        });
+    }), bestMilliseconds([&] {
+        for (auto& kv : objects) {
+            if (kv.second.model == nullptr) continue;
+            legacySum += kv.second.transform.translation.x;
+        }
+    }));
+
+    report("transform + light", bestMilliseconds([&] {
+        registry.view<TransformComponent, PointLightComponent>().each([&](Entity, TransformComponent& transform, PointLightComponent& light) {
+            registrySum += transform.translation.x * light.lightIntensity;
+        });
+    }), bestMilliseconds([&] {
+        for (auto& kv : objects) {
+            if (kv.second.pointLight == nullptr) continue;
+            legacySum += kv.second.transform.translation.x * kv.second.pointLight->lightIntensity;
+        }
+    }));
+
+    if (registrySum != legacySum) {
+        std::cout << "registry and Object::Map visited different objects\n";
+        return 1;
+    }
+    return 0;
+}
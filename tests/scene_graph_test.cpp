@@ -0,0 +1,89 @@
+#include "Check.hpp"
+
+#include "Registry.hpp"
+#include "SceneGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    bool hasChild(const SceneGraph& graph, Entity parent, Entity child) {
+        const auto& children = graph.getChildren(parent);
+        return std::find(children.begin(), children.end(), child) != children.end();
+    }
+
+    // An entity is destroyed and its index handed out again before the graph's next update, so
+    // the new entity takes over a slot still linked into the hierarchy
+    void checkRecycledIndexInSameTick() {
+        Registry registry;
+        SceneGraph graph;
+        Entity root = registry.create();
+        Entity middle = registry.create();
+        Entity leaf = registry.create();
+        graph.setParent(middle, root);
+        graph.setParent(leaf, middle);
+        graph.update(registry);
+
+        registry.destroy(middle);
+        Entity recycled = registry.create();
+        CHECK((recycled & ENTITY_INDEX_MASK) == (middle & ENTITY_INDEX_MASK));
+        CHECK(recycled != middle);
+
+        graph.setParent(recycled, leaf);
+        CHECK(!graph.contains(middle));
+        CHECK(graph.getChildren(root).empty());
+        CHECK(graph.getParent(leaf) == NULL_ENTITY);
+        CHECK(graph.getParent(recycled) == leaf);
+        CHECK(hasChild(graph, leaf, recycled));
+        CHECK(graph.getChildren(recycled).empty());
+
+        graph.update(registry);
+        CHECK(graph.size() == 3);
+        CHECK(graph.levelCount() == 2);
+    }
+
+    // the same with the recycled entity added as a root
+    void checkRecycledIndexAsRoot() {
+        Registry registry;
+        SceneGraph graph;
+        Entity parent = registry.create();
+        Entity child = registry.create();
+        graph.setParent(child, parent);
+
+        registry.destroy(parent);
+        Entity recycled = registry.create();
+        CHECK((recycled & ENTITY_INDEX_MASK) == (parent & ENTITY_INDEX_MASK));
+
+        graph.setParent(recycled);
+        CHECK(graph.getParent(child) == NULL_ENTITY);
+        CHECK(graph.getChildren(recycled).empty());
+
+        graph.update(registry);
+        CHECK(graph.size() == 2);
+        CHECK(graph.levelCount() == 1);
+    }
+
+    void checkCycleRejected() {
+        Registry registry;
+        SceneGraph graph;
+        Entity a = registry.create();
+        Entity b = registry.create();
+        graph.setParent(b, a);
+        bool threw = false;
+        try {
+            graph.setParent(a, b);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(graph.getParent(a) == NULL_ENTITY);
+        CHECK(graph.getParent(b) == a);
+    }
+}
+
+int main() {
+    checkRecycledIndexInSameTick();
+    checkRecycledIndexAsRoot();
+    checkCycleRejected();
+    return check::finish("scene_graph_test");
+}
@@ -0,0 +1,48 @@
+#include "TransformBatch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define ITERATIONS 10
+
+namespace {
+    template<typename Func>
+    double bestMilliseconds(Func func) {
+        double best = 1e30;
+        for (int i = 0; i < ITERATIONS; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+}
+
+int main() {
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> value(-3.f, 3.f);
+
+    std::cout << "computeTransforms (" << transformBatchIsa() << ") against the scalar reference, best of " << ITERATIONS << "\n";
+    std::cout << std::setw(10) << "count" << std::setw(14) << "batch" << std::setw(14) << "scalar" << "\n";
+    for (size_t count : {10000, 100000, 1000000}) {
+        TransformBatch batch;
+        batch.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            batch.set(i, {value(rng), value(rng), value(rng)}, {value(rng), value(rng), value(rng)}, {1.f, 1.f, 1.f});
+        }
+        std::vector<glm::mat4> models(count);
+        std::vector<glm::mat3> normals(count);
+
+        double batchMs = bestMilliseconds([&] { computeTransforms(batch, models.data(), normals.data()); });
+        double scalarMs = bestMilliseconds([&] { computeTransformsScalar(batch, models.data(), normals.data()); });
+        std::cout << std::setw(10) << count << std::fixed << std::setprecision(3)
+            << std::setw(11) << batchMs << " ms" << std::setw(11) << scalarMs << " ms"
+            << std::setw(8) << std::setprecision(1) << scalarMs / batchMs << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "Check.hpp"
+
+#include "TransformBatch.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// largest absolute difference allowed from the std::sin / std::cos reference
+#define MAX_ABS_ERROR 1e-5f
+// sinCos promises its accuracy below this magnitude
+#define SIN_COS_RANGE 8192.f
+
+namespace {
+    float maxError(const float* a, const float* b, size_t count) {
+        float error = 0.f;
+        for (size_t i = 0; i < count; i++) {
+            error = std::max(error, std::abs(a[i] - b[i]));
+        }
+        return error;
+    }
+
+    float checkSinCos(const std::vector<float>& x) {
+        std::vector<float> sinOut(x.size()), cosOut(x.size());
+        sinCos(x.data(), sinOut.data(), cosOut.data(), x.size());
+        float error = 0.f;
+        for (size_t i = 0; i < x.size(); i++) {
+            error = std::max(error, std::abs(sinOut[i] - std::sin(x[i])));
+            error = std::max(error, std::abs(cosOut[i] - std::cos(x[i])));
+        }
+        return error;
+    }
+
+    // counts that are not a multiple of any vector width exercise the tail handling too
+    float checkTransforms(std::mt19937& rng, size_t count, float maxAngle) {
+        std::uniform_real_distribution<float> translation(-100.f, 100.f);
+        std::uniform_real_distribution<float> rotation(-maxAngle, maxAngle);
+        std::uniform_real_distribution<float> scale(0.5f, 2.f);
+        TransformBatch batch;
+        batch.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            batch.set(i,
+                {translation(rng), translation(rng), translation(rng)},
+                {rotation(rng), rotation(rng), rotation(rng)},
+                {scale(rng), scale(rng), scale(rng)});
+        }
+
+        std::vector<glm::mat4> models(count), referenceModels(count);
+        std::vector<glm::mat3> normals(count), referenceNormals(count);
+        computeTransforms(batch, models.data(), normals.data());
+        computeTransformsScalar(batch, referenceModels.data(), referenceNormals.data());
+        return std::max(
+            maxError(&models[0][0][0], &referenceModels[0][0][0], count * 16),
+            maxError(&normals[0][0][0], &referenceNormals[0][0][0], count * 9));
+    }
+}
+
+int main() {
+    std::mt19937 rng{42};
+    std::cout << "transform batch isa: " << transformBatchIsa() << "\n";
+
+    std::vector<float> angles;
+    std::uniform_real_distribution<float> anywhere(-SIN_COS_RANGE, SIN_COS_RANGE);
+    for (int i = 0; i < 100000; i++) {
+        angles.push_back(anywhere(rng));
+    }
+    // the range reduction loses the most precision at the top of the range
+    for (float edge : {-SIN_COS_RANGE, SIN_COS_RANGE}) {
+        float x = edge;
+        for (int i = 0; i < 20000; i++) {
+            angles.push_back(x);
+            x = std::nextafter(x, 0.f);
+        }
+    }
+    for (float x : {0.f, -0.f, 1e-20f, 1.f, glm::pi<float>(), 0.5f * glm::pi<float>()}) {
+        angles.push_back(x);
+        angles.push_back(-x);
+    }
+    float sinCosError = checkSinCos(angles);
+    std::cout << "sinCos max abs error: " << sinCosError << "\n";
+    CHECK(sinCosError <= MAX_ABS_ERROR);
+
+    float smallAngleError = 0.f, largeAngleError = 0.f;
+    for (size_t count : {1, 3, 7, 13, 1000, 4099}) {
+        smallAngleError = std::max(smallAngleError, checkTransforms(rng, count, glm::two_pi<float>()));
+        largeAngleError = std::max(largeAngleError, checkTransforms(rng, count, SIN_COS_RANGE));
+    }
+    std::cout << "transform max abs error: " << smallAngleError << " (|angle| < 2pi), "
+        << largeAngleError << " (|angle| < " << SIN_COS_RANGE << ")\n";
+    CHECK(smallAngleError <= MAX_ABS_ERROR);
+    CHECK(largeAngleError <= MAX_ABS_ERROR);
+
+    return check::finish("transform_batch_test");
+}